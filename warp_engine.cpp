@@ -1,8 +1,27 @@
 //===================================================================
 //  Needle‑Hull Mk‑1  ·  Natário Warp‑Bubble Visualiser (WebAssembly)
 //  ---------------------------------------------------------------
-//  Single‑file build:  emcc warp_engine.cpp -O3 -s WASM=1 -std=c++17 \
-//                      -s USE_GLFW=3 -s FULL_ES3=1 -o warp.js
+//  Single‑file build:  emcc warp_engine.cpp -O3 -s WASM=1 -std=c++17
+//                      -msimd128 -s USE_GLFW=3 -s FULL_ES3=1 -lembind
+//                      -lidbstore.js -o warp.js
+//  Worker build     :  emcc warp_engine.cpp -O3 -s WASM=1 -std=c++17
+//                      -msimd128 -DWARP_OFFSCREEN -pthread -s PROXY_TO_PTHREAD=1
+//                      -s OFFSCREENCANVAS_SUPPORT=1 -s MAX_WEBGL_VERSION=2
+//                      -s PTHREAD_POOL_SIZE=navigator.hardwareConcurrency
+//                      -s FULL_ES3=1 -lembind -lidbstore.js -o warp_mt.js
+//    (render loop + WebGL context live in a pthread that owns the
+//     transferred #canvas; the page must be cross‑origin isolated)
+//    (the pthread pool also runs referenceStill()'s tiles on every core)
+//  Benchmark build  :  emcc warp_engine.cpp -O3 -s WASM=1 -std=c++17
+//                      -msimd128 -DWARP_BENCH -s USE_GLFW=3 -s FULL_ES3=1
+//                      -lembind -s EXIT_RUNTIME=1 --emrun -o warp_bench.html
+//      emrun --browser=chrome --browser_args=--headless=new --kill_exit
+//            warp_bench.html          (prints one JSON document to stdout)
+//  Native build     :  c++ warp_engine.cpp -O3 -std=c++17 -lglfw -lGLESv2
+//                      -pthread -o warp_native      [-DWARP_BENCH for CI timing]
+//    (GLFW window with a GLES 3.0 context: Mesa / vendor ES profiles on
+//     Linux, ANGLE on Windows; same core, see PLATFORM LAYER)
+//  Dropping -msimd128 falls back to the scalar betaFieldBatch loop.
 //  ---------------------------------------------------------------
 //  This file grafts the core pieces taken from the original
 //  *CPU-geodesic.cpp*, *geodesic.comp* and *ray_tracing.cpp* into a
@@ -11,21 +30,72 @@
 //  and paints the corresponding Natário warp bubble in real time.
 //===================================================================
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
 #include <emscripten/html5.h>
 #include <emscripten/bind.h>
+#else
+#define EMSCRIPTEN_KEEPALIVE                 // native: the bridge is plain extern "C"
+#endif
 #include <GLES3/gl3.h>
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+#if defined(WARP_OFFSCREEN) && !defined(__EMSCRIPTEN__)
+#error "WARP_OFFSCREEN is the browser worker build"
+#endif
+#ifdef WARP_OFFSCREEN
+#include <emscripten/proxying.h>
+#include <emscripten/threading.h>
+#include <pthread.h>
+#include <functional>
+#else
 #include <GLFW/glfw3.h>
+#endif
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
 #include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <atomic>
 #include <cmath>
 #include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <initializer_list>
+#include <deque>
+#include <mutex>
+#if defined(__EMSCRIPTEN_PTHREADS__) || !defined(__EMSCRIPTEN__)
+#include <thread>
+#endif
 
 using namespace glm;
 using Clock = std::chrono::high_resolution_clock;
+
+//---------------------------------------------------------------
+//  PLATFORM LAYER  (browser or native; defined next to initGL)
+//---------------------------------------------------------------
+//  The core (metric, Camera, shaders, UBO layout, passes) only reaches
+//  the host through these calls, so the same file also builds natively
+//  on GLFW + GLES 3 for offline renders, CI timing and real profilers.
+//  Natively the bridge functions stay callable as plain extern "C";
+//  only the embind table and its typed‑array views are browser‑only.
+static bool   glExtension(const char *name);           // WebGL: enables it as well
+static void   loopRun(void (*frame)());                // never returns
+static void   loopPause();                             // until loopResume()
+static void   loopResume();
+static void   loopExit(int code);
+static bool   canvasCssSize(double &w,double &h);      // false: no layout yet
+static double canvasPixelRatio();
+static void   canvasSetSize(int w,int h);              // drawing buffer
+static void   canvasOnResize(void (*f)());
+static void   storeLoad(const char *db,const char *key,
+                        void (*loaded)(const void *data,int n),void (*missing)());
+static void   storeSave(const char *db,const char *key,const void *data,int n);
 // ---------------------------------------------------------------
 //  CONSTANTS & GLOBALS
 // ---------------------------------------------------------------
@@ -41,9 +111,36 @@ struct WarpUniforms {
     float powerAvg_MW;   // Ui: 83.3  average power (MW)
     float exoticMass_kg; // Ui: 1.405×10³ exotic kg
 };
-static WarpUniforms gWarp;                // updated from JS each frame
+//  Bubble 0 is the live one (gWarp); up to WARP_MAX_BUBBLES are drawn
+//  side by side as panels of one instanced draw (MULTI‑BUBBLE PANELS).
+#define WARP_MAX_BUBBLES 8
+static WarpUniforms  gBubbles[WARP_MAX_BUBBLES];
+static WarpUniforms &gWarp = gBubbles[0]; // updated from JS each frame
+static uint32_t     gWarpGen  = 0;        // bumped whenever any bubble changes
+static uint32_t     gShapeGen = 0;        // … and this when β itself changes
+static int          gBubbleCount = 1;     // panels in use
+static vec4         gBubbleRect[WARP_MAX_BUBBLES] = {vec4(-1,-1,1,1)};  // NDC
 static GLuint       gUBO = 0;            // UBO bound at binding‑point 0
 
+//  Marcher tuning shared by C++ and every shader variant: each entry
+//  becomes a constexpr here and a #define in kFragConstants, which
+//  shaders prepend ahead of kShiftKernel.
+#define WARP_MARCH_CONSTANTS(X)                                          \
+    X(int,   kMaxSteps,    192 )  /* step budget ceiling (≤ 255)      */ \
+    X(int,   kBetaLUTSize, 512 )  /* radial LUT texels (largest row)  */ \
+    X(float, kSupport,     3.5 )  /* exp(-3.5²) ≈ 5e-6 : β ≡ 0 beyond */ \
+    X(float, kStepMin,     0.02)  /* step bounds in units of R        */ \
+    X(float, kStepMax,     0.5 )                                         \
+    X(float, kStepTol,     0.05)  /* target |Δβ| per step             */ \
+    X(float, kHorizon,     1e3 )  /* |p| bound: ray stalls on horizon */ \
+    X(float, kTemporalMaxWeight, 16) /* history samples per pixel cap  */ \
+    X(int,   kMaxBubbles,  WARP_MAX_BUBBLES)  /* panels per draw        */
+#define WARP_STR(v)               #v
+#define WARP_CXX_CONST(T,name,v)  constexpr T name = T(v);
+#define WARP_GLSL_CONST(T,name,v) "#define " #name " " #T "(" WARP_STR(v) ")\n"
+WARP_MARCH_CONSTANTS(WARP_CXX_CONST)
+static const char *kFragConstants = WARP_MARCH_CONSTANTS(WARP_GLSL_CONST);
+
 //---------------------------------------------------------------
 //  NATÁRIO ZERO‑EXPANSION METRIC HELPERS
 //---------------------------------------------------------------
@@ -51,6 +148,56 @@ static GLuint       gUBO = 0;            // UBO bound at binding‑point 0
 //      ds² = -dt² + (δ_ij + β_i β_j) dx^i dx^j + 2 β_i dx^i dt
 //  where β is the *shift* (bubble velocity field).
 //---------------------------------------------------------------
+//  The shift and its derivatives are written once, in the subset that
+//  C++/glm and GLSL ES 3.00 share.  WARP_SHIFT_SOURCE expands to C++
+//  in float (shift32) and double (shift64), and is stringised into
+//  kShiftKernel, which every marcher and tracer shader includes.  The
+//  GPU march, the LUT bake and the CPU reference therefore integrate
+//  the same field.  In units of R:
+//      β = k·x,   ∂_j β_i = k(δ_ij − 2 x_i x_j),   k = β₀·e^{-|x|²}
+//  This is β₀·(r/R)·e^{-(r/R)²}·x̂.  One exp gives β, ∂β and the ray
+//  rate together.  rayRate is the Hamiltonian flow of the Natário null
+//  geodesic with lapse 1 (E conserved):
+//      dx/dλ = p + w·β,   dp/dλ = −w·∇(β·p),   w = E − β·p
+//  ∇(β·p) = (∂β)ᵀp is taken without forming the matrix.  shiftJet is
+//  there for integrators that need the whole Jacobian.  stepScale is the
+//  marcher's step for a given k, which radial() and the LUT bake share;
+//  it reads kStepTol/Min/Max, so WARP_MARCH_CONSTANTS comes first.  Type names are
+//  real / rvec3 / rmat3, and literals are written real(n), so one text
+//  compiles in both languages.
+#define WARP_SHIFT_SOURCE(EMIT) EMIT(                                       \
+struct ShiftJet { rvec3 beta; rmat3 dbeta; };                               \
+struct RayRate  { rvec3 dx; rvec3 dp; };                                    \
+real  shiftScale(real s2,real beta0){ return beta0*exp(-s2); }              \
+real  stepScale(real s2,real k){                                            \
+    return clamp(real(kStepTol)/(abs(k)*(real(1)+real(2)*s2)+real(1e-6)),   \
+                 real(kStepMin),real(kStepMax));                            \
+}                                                                           \
+rvec3 shiftAt(rvec3 x,real k){ return k*x; }                                \
+rvec3 shiftGradDot(rvec3 x,real k,rvec3 p){ return k*(p - real(2)*dot(x,p)*x); } \
+ShiftJet shiftJet(rvec3 x,real k){                                          \
+    ShiftJet j;                                                             \
+    j.beta  = k*x;                                                          \
+    j.dbeta = k*(rmat3(real(1)) - real(2)*outerProduct(x,x));               \
+    return j;                                                               \
+}                                                                           \
+RayRate rayRate(rvec3 x,rvec3 p,real E,real k){                             \
+    rvec3 b = k*x;                                                          \
+    real  w = E - dot(b,p);                                                 \
+    RayRate r;                                                              \
+    r.dx = p + w*b;                                                         \
+    r.dp = -w*shiftGradDot(x,k,p);                                          \
+    return r;                                                               \
+})
+#define WARP_EMIT_CXX(...)  __VA_ARGS__
+#define WARP_EMIT_GLSL(...) #__VA_ARGS__
+namespace shift32 { using real = float;  using rvec3 = vec3;  using rmat3 = mat3;
+                    WARP_SHIFT_SOURCE(WARP_EMIT_CXX) }
+namespace shift64 { using real = double; using rvec3 = dvec3; using rmat3 = dmat3;
+                    WARP_SHIFT_SOURCE(WARP_EMIT_CXX) }
+static const char *kShiftKernel =
+    "#define real  float\n#define rvec3 vec3\n#define rmat3 mat3\n"
+    WARP_SHIFT_SOURCE(WARP_EMIT_GLSL) "\n";
 
 inline vec3 betaField(const vec3 &x)
 {
@@ -59,28 +206,158 @@ inline vec3 betaField(const vec3 &x)
     // β₀    =  dutyCycle * g_y              (dimensionless)
     // R      is keyed to sagDepth (nm ⇒ m)
 
-    float R = gWarp.sagDepth_nm * 1e‑9f;               // sag depth → metres
-    float r = length(x);
-    if(r < 1e‑9f) return vec3(0.0f);
+    float R = gWarp.sagDepth_nm * 1e-9f;               // sag depth → metres
+    if(length(x) < 1e-9f) return vec3(0.0f);
+
+    vec3 s = x / R;                                     // radial & C∞ smooth
+    return shift32::shiftAt(s,shift32::shiftScale(dot(s,s),gWarp.dutyCycle*gWarp.g_y));
+}
+
+//---------------------------------------------------------------
+//  BATCH β SAMPLER  (structure‑of‑arrays, WASM SIMD128)
+//---------------------------------------------------------------
+//  Bulk CPU queries (field slices, dashboard statistics) go through
+//  betaFieldBatch, four points per iteration with -msimd128.  Since
+//  (r/R)·x̂ ≡ x/R, each point needs r² and one exp only – no sqrt and
+//  no divide.  wasm has no vector exp, so both paths use the same
+//  Cephes‑style expf (≈1 ulp on the x ≤ 0 range used here), so SIMD
+//  and scalar builds agree.  The r < 1 nm cut of the scalar betaField
+//  is kept.  Feed it cache‑sized slabs: whole‑grid calls are bound by
+//  memory traffic, not by the arithmetic.
+static inline float expNeg(float x){               // e^x for x ≤ 0
+    x = std::fmax(x,-87.0f);                       // keep 2^n normal
+    float n = std::nearbyint(x*1.44269504f);
+    float r = x - n*0.693359375f + n*2.12194440e-4f;
+    float p = 1.9875691500e-4f;
+    p = p*r + 1.3981999507e-3f;
+    p = p*r + 8.3334519073e-3f;
+    p = p*r + 4.1665795894e-2f;
+    p = p*r + 1.6666665459e-1f;
+    p = p*r + 5.0000001201e-1f;
+    p = p*r*r + r + 1.0f;
+    int32_t bits = (int32_t(n) + 127) << 23;
+    float scale; std::memcpy(&scale,&bits,sizeof(scale));
+    return p*scale;
+}
+
+#ifdef __wasm_simd128__
+static inline v128_t expNeg4(v128_t x){
+    x = wasm_f32x4_pmax(x,wasm_f32x4_splat(-87.0f));
+    v128_t n = wasm_f32x4_nearest(wasm_f32x4_mul(x,wasm_f32x4_splat(1.44269504f)));
+    v128_t r = wasm_f32x4_sub(x,wasm_f32x4_mul(n,wasm_f32x4_splat(0.693359375f)));
+    r = wasm_f32x4_add(r,wasm_f32x4_mul(n,wasm_f32x4_splat(2.12194440e-4f)));
+    v128_t p = wasm_f32x4_splat(1.9875691500e-4f);
+    p = wasm_f32x4_add(wasm_f32x4_mul(p,r),wasm_f32x4_splat(1.3981999507e-3f));
+    p = wasm_f32x4_add(wasm_f32x4_mul(p,r),wasm_f32x4_splat(8.3334519073e-3f));
+    p = wasm_f32x4_add(wasm_f32x4_mul(p,r),wasm_f32x4_splat(4.1665795894e-2f));
+    p = wasm_f32x4_add(wasm_f32x4_mul(p,r),wasm_f32x4_splat(1.6666665459e-1f));
+    p = wasm_f32x4_add(wasm_f32x4_mul(p,r),wasm_f32x4_splat(5.0000001201e-1f));
+    p = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(wasm_f32x4_mul(p,r),r),r),
+                       wasm_f32x4_splat(1.0f));
+    v128_t e = wasm_i32x4_shl(wasm_i32x4_add(wasm_i32x4_trunc_sat_f32x4(n),
+                                             wasm_i32x4_splat(127)),23);
+    return wasm_f32x4_mul(p,e);
+}
+#endif
+
+//  bubble 0's field shape (β₀, sagDepth_nm) packed into one word for
+//  the batch bridge.  commitBubble stores it.  betaBatchRun loads it, so
+//  the worker build's page thread never reads gWarp while the render
+//  thread writes it.
+static std::atomic<uint64_t> gBatchShape{0};
+
+static uint64_t packBatchShape(float beta0,float sag){
+    uint32_t a, b;
+    std::memcpy(&a,&beta0,sizeof(a)); std::memcpy(&b,&sag,sizeof(b));
+    return uint64_t(a) | uint64_t(b)<<32;
+}
 
-    float beta0 = gWarp.dutyCycle * gWarp.g_y;
-    float prof  = (r / R) * exp(‑(r*r) / (R*R));
-    return beta0 * prof * (x / r);                      // radial & C∞ smooth
+//  β at n points: (x,y,z)[i] → (bx,by,bz)[i] for a field of shape
+//  (β₀, sagDepth_nm); arrays may be unaligned
+void betaFieldBatch(const float *x,const float *y,const float *z,
+                    float *bx,float *by,float *bz,size_t n,float beta0,float sag_nm)
+{
+    const float R   = sag_nm * 1e-9f;
+    const float k   = beta0 / R;
+    const float iR2 = 1.0f/(R*R);
+    size_t i = 0;
+#ifdef __wasm_simd128__
+    const v128_t vk = wasm_f32x4_splat(k), vmiR2 = wasm_f32x4_splat(-iR2);
+    const v128_t cut = wasm_f32x4_splat(1e-18f);             // (1 nm)²
+    for(; i+4<=n; i+=4){
+        v128_t px = wasm_v128_load(x+i), py = wasm_v128_load(y+i), pz = wasm_v128_load(z+i);
+        v128_t r2 = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(px,px),
+                                   wasm_f32x4_mul(py,py)),wasm_f32x4_mul(pz,pz));
+        v128_t s  = wasm_f32x4_mul(vk,expNeg4(wasm_f32x4_mul(r2,vmiR2)));
+        s = wasm_v128_and(s,wasm_f32x4_ge(r2,cut));
+        wasm_v128_store(bx+i,wasm_f32x4_mul(s,px));
+        wasm_v128_store(by+i,wasm_f32x4_mul(s,py));
+        wasm_v128_store(bz+i,wasm_f32x4_mul(s,pz));
+    }
+#endif
+    for(; i<n; ++i){
+        float r2 = x[i]*x[i] + y[i]*y[i] + z[i]*z[i];
+        float s  = r2 >= 1e-18f ? k*expNeg(-r2*iR2) : 0.0f;
+        bx[i] = s*x[i]; by[i] = s*y[i]; bz[i] = s*z[i];
+    }
+}
+//  … of bubble 0, from the thread that owns gWarp
+void betaFieldBatch(const float *x,const float *y,const float *z,
+                    float *bx,float *by,float *bz,size_t n)
+{
+    betaFieldBatch(x,y,z,bx,by,bz,n,gWarp.dutyCycle*gWarp.g_y,gWarp.sagDepth_nm);
 }
 
 //---------------------------------------------------------------
 //  CAMERA (little trimmed version of the original)
 //---------------------------------------------------------------
+//  pos/tgt stay in metres for the bridge, but nothing downstream uses
+//  the view's translation: the GPU gets the rotation plus the eye in
+//  units of each bubble's R (eyeR), formed in double.  The clip planes
+//  are in those units too, so the depth range can no longer collapse.
 struct Camera {
-    vec3 pos  = vec3(0, 0, 8e‑9f);   // start *inside* the bubble (nm scale)
+    static constexpr float kNear = 1e-3f, kFar = 1e5f;   // units of R
+    vec3 pos  = vec3(0, 0, 8e-9f);   // start *inside* the bubble (nm scale)
     vec3 tgt  = vec3(0);
     float fov = 60.f;
-    mat4 view()  const {return lookAt(pos, tgt, vec3(0,1,0));}
-    mat4 proj(float aspect) const {return perspective(radians(fov), aspect, 1e‑12f, 1e‑4f);}    // nm clip‑planes
+    float ortho = 0.f;               // > 0: parallel rays, half‑height in units of R (VIEWS)
+    mat4 view()  const {             // straight up or down: keep −z as up
+        vec3 d = tgt - pos;
+        bool pole = std::abs(d.y) > 0.999f*length(d);
+        return lookAt(pos, tgt, pole ? vec3(0,0,-1) : vec3(0,1,0));
+    }
+    mat4 proj(float aspect) const {return perspective(radians(fov), aspect, kNear, kFar);}
+    vec3 eyeR(float sagDepth_nm) const {
+        return vec3(dvec3(pos)/(double(sagDepth_nm)*1e-9));
+    }
 } gCam;
 
 //---------------------------------------------------------------
-//  GLSL SHADERS (minimal – "compute" replaced by full‑screen quad)
+//  VIEWS  (inset cameras drawn by the same frame())
+//---------------------------------------------------------------
+//  A dashboard shows the main view plus small top / side insets of the
+//  bubble.  Each inset is a Camera and a canvas rectangle.  After the
+//  main view is presented, frame() draws every inset straight into the
+//  canvas with glViewport, reusing the shown program, the UBO and the
+//  LUT.  An inset therefore costs its pixels and one draw, never a
+//  context or a compile.  The exception is a main view that is temporal
+//  or physics: its variant is then reused without those bits.  Panels
+//  (MULTI‑BUBBLE PANELS) lay out inside every view alike.  Insets are
+//  traced at full resolution without temporal accumulation, tile
+//  skipping or physics channels, all of which stay with the main view.
+//  An orthographic inset (ortho > 0) traces parallel rays from a plane
+//  through its eye, so the eye should sit outside the support.
+constexpr int kMaxViews = 4;            // insets over the main view
+struct View {
+    vec4   rect = vec4(0.75f,0.f,0.25f,0.25f);   // canvas fractions x, y, w, h; origin bottom‑left
+    Camera cam;
+};
+static View gViews[kMaxViews];
+static int  gViewCount = 0;
+
+//---------------------------------------------------------------
+//  GLSL SHADERS (full‑screen quad driving a per‑pixel null‑geodesic
+//  marcher – the fragment‑side port of *geodesic.comp*)
 //---------------------------------------------------------------
 static const char *kVert = R"GLSL(
 #version 300 es
@@ -91,82 +368,2524 @@ void main(){
     gl_Position = vec4(aPos,0,1);
 })GLSL";
 
-static const char *kFrag = R"GLSL(
-#version 300 es
+//  std140 mirror of the GLSL Bubble struct: one panel rect + parameters
+struct BubbleGPU {
+    vec4         rect;               // panel in NDC: x0, y0, x1, y1
+    WarpUniforms w;
+    float        pad;
+};
+static_assert(sizeof(BubbleGPU)==48,"std140 array stride of Bubble");
+
+//  declared identically by the marcher's vertex and fragment stages
+static const char *kWarpBlock = R"GLSL(
 precision highp float;
-uniform WarpUniforms {              // must match C++ layout
+struct Bubble {
+    vec4  rect;
     float dutyCycle,g_y,cavityQ,sagDepth_nm,tsRatio,powerAvg_MW,exoticMass_kg;
 };
+layout(std140) uniform WarpUniforms {   // must match C++ BubbleGPU[kMaxBubbles]
+    Bubble uBubble[kMaxBubbles];
+};
+)GLSL";
+
+//  instance i draws its quad (or tile) into panel uBubble[i].rect
+static const char *kVertBubble = R"GLSL(
+layout(location=0) in vec2 aPos;
+out vec2 vUV;
+flat out int vInst;
+void main(){
+    vec4 r = uBubble[gl_InstanceID].rect;
+    vUV    = aPos*0.5 + 0.5;
+    vInst  = gl_InstanceID;
+    gl_Position = vec4(mix(r.xy,r.zw,vUV),0,1);
+})GLSL";
+static_assert(kMaxSteps<=255,"step count must fit the 8‑bit debug view");
+
+//  Rays are traced *backwards* from the eye with the Hamiltonian form
+//  of the metric  ds² = -dt² + (dx - β dt)²  (lapse 1, flat slices):
+//      H      = ½ ( |p|² - (E - β·p)² ) = 0        (null)
+//      dx/dλ  = p + (E - β·p) β
+//      dp/dλ  = -(E - β·p) ∇(β·p)                 (p held fixed)
+//  E = -p_t is conserved because β does not depend on t.  The step is
+//  sized from the local field gradient and the ray leaves the loop as
+//  soon as it exits the support sphere of exp(-(r/R)²) heading outward.
+//  Where |β| > 1 traced-back rays pile up on the |β| = 1 horizon with
+//  diverging |p|; they are cut off once the shift leaves kHorizon.
+//  Positions and steps are in units of R about the bubble centre, so
+//  every quantity the marcher touches is O(1) whatever the nm scale
+//  or the zoom; highp float then holds ~1e-7 R without emulation.
+//  kFrag has no #version line: startVariant() prepends it together
+//  with the variant switches (WARP_MAX_STEPS, WARP_DEBUG_VIEW,
+//  WARP_USE_LUT, WARP_LUT_SIZE, WARP_TEMPORAL, WARP_SKY_ONLY,
+//  WARP_PHYSICS), kFragConstants and kShiftKernel (the shared β
+//  kernel of NATÁRIO … HELPERS).  WARP_PHYSICS adds the float channel output of
+//  PHYSICS CHANNELS at location 1.
+//  WARP_SKY_ONLY is the flat‑space answer for tiles whose rays all miss
+//  the support sphere (see EMPTY‑SPACE SKIPPING).
+//
+//  WARP_TEMPORAL = 1 (checkerboard) or 2 (one pixel per 2×2 quad)
+//  traces only the pixel class uPhase this frame.  Every other pixel
+//  reuses the history sample its ray direction hit last frame.  The
+//  sky is at infinity, so reprojecting directions with the previous
+//  proj·view is exact for it.  Traced pixels are jittered by uJitter
+//  and averaged into the history, up to kTemporalMaxWeight samples
+//  (A = weight / kTemporalMaxWeight), while the camera holds still.
+static const char *kFrag = R"GLSL(
+uniform mat3 uEyeRot;               // camera‑to‑world rotation
+uniform vec3 uEyeR[kMaxBubbles];    // eye in units of bubble i's R
+uniform vec2 uProjScale;            // 1/proj[0][0], 1/proj[1][1]; ortho: half‑extents in R
+uniform bool uOrtho;                // parallel rays (VIEWS)
+#if WARP_TEMPORAL
+uniform sampler2D uHistory;         // last accumulation (unit 1)
+uniform mat4 uPrevViewProj;         // last frame's proj·view
+uniform vec2 uHistScale;            // rendered fraction of uHistory
+uniform vec2 uJitter;               // sub‑pixel offset in NDC
+uniform int  uPhase;                // pixel class traced now, -1 = all
+uniform bool uMotion;               // camera moved: history is a fallback only
+#endif
+#if WARP_USE_LUT
+uniform sampler2D uBetaLUT;         // RG: β₀·e^{-s²}, h(s)/R  vs u = s²/kSupport²; row = bubble
+#endif
+
+in  vec2 vUV;                       // panel‑local
+flat in int vInst;
+layout(location=0) out vec4 frag;
+#if WARP_PHYSICS
+layout(location=1) out vec4 physics;   // peak |β|, redshift z, ∫dt /R, steps
+#endif
+vec4 phys = vec4(0.0);              // trace()'s physics channels
+
+float dutyCycle, g_y;               // this panel's bubble, set by main()
+vec2  projScale;                    // uProjScale at the panel's aspect
+
+// radial part of the field at s² = (r/R)²:  (β₀·e^{-s²}, step / R)
+vec2 radial(float s2){
+#if WARP_USE_LUT
+    const float n = float(WARP_LUT_SIZE);        // texels in use of the kBetaLUTSize row
+    float u = min(s2*(1.0/(kSupport*kSupport)),1.0);
+    return texture(uBetaLUT,vec2((u*(n-1.0)+0.5)/float(kBetaLUTSize),
+                                 (float(vInst)+0.5)/float(kMaxBubbles))).rg;
+#else
+    float k = shiftScale(s2,dutyCycle*g_y);
+    return vec2(k,stepScale(s2,k));
+#endif
+}
+
+// kShiftKernel's β with k from radial();  x in units of R
+vec3 betaField(vec3 x){
+    return shiftAt(x,radial(dot(x,x)).x);
+}
+
+// λ is in units of R as well, so ∂/∂x carries no 1/R factor
+void deriv(vec3 x,vec3 p,float E,out vec3 dx,out vec3 dp){
+    RayRate r = rayRate(x,p,E,radial(dot(x,x)).x);
+    dx = r.dx; dp = r.dp;
+}
+
+// celestial reference grid – makes the lensing visible
+vec3 sky(vec3 d){
+    vec2 uv = vec2(atan(d.z,d.x)*(12.0/6.2831853),
+                   asin(clamp(d.y,-1.0,1.0))*(12.0/3.1415927));
+    vec2 g  = abs(fract(uv)-0.5);
+    float line = smoothstep(0.46,0.5,max(g.x,g.y));
+    return mix(vec3(0.02,0.03,0.06),vec3(0.35,0.55,0.90),line);
+}
+
+// colour (or debug value) seen along the eye ray through ndc
+vec3 trace(vec2 ndc){
+    vec3  x    = uEyeR[vInst];
+    vec3  p    = normalize(uEyeRot*vec3(ndc*projScale,-1.0));
+    if(uOrtho){ x += uEyeRot*vec3(ndc*projScale,0.0); p = -uEyeRot[2]; }
+    float E    = 1.0 + dot(betaField(x),p);   // |p|=1 for the Eulerian eye
+    float beta0= abs(dutyCycle*g_y);
+    float glow = 0.0, peak = 0.0, dt = 0.0;
+
+    // outside the support the ray is straight: jump to the sphere or leave.
+    // disc = Rs² - |x⊥|² rather than (x·p)² - (|x|² - Rs²): no cancellation
+    // when the eye is thousands of R out
+    float xp = dot(x,p);
+    if(dot(x,x) > kSupport*kSupport){
+        vec3  xt   = x - xp*p;
+        float disc = kSupport*kSupport - dot(xt,xt);
+        if(xp >= 0.0 || disc <= 0.0){
+#if WARP_DEBUG_VIEW == 1
+            return vec3(0);
+#else
+            return sky(p);
+#endif
+        }
+        x += (-xp - sqrt(disc))*p;
+    }
+
+    vec3 dx = p;
+    int steps = 0;
+    bool trapped = false;
+    for(int i=0;i<WARP_MAX_STEPS;++i,++steps){
+        float s2 = dot(x,x);
+        if(s2 > kSupport*kSupport && dot(x,dx) > 0.0) break;
+        float pp = dot(p,p);
+        if(pp > kHorizon*kHorizon || pp*kHorizon*kHorizon < 1.0){ trapped = true; break; }
+
+        vec3 k1x,k1p,k2x,k2p;                    // RK2 midpoint
+        deriv(x,p,E,k1x,k1p);
+        // |∂β|·R ≈ β₀·e^{-s²}(1+2s²): big steps where the field is flat;
+        // h is a spatial length, so divide by |dx/dλ| to get a λ step
+        float h = radial(s2).y/max(length(k1x),1e-6);
+        deriv(x + 0.5*h*k1x,p + 0.5*h*k1p,E,k2x,k2p);
+        x += h*k2x;  p += h*k2p;  dx = k2x;
+        vec3  bx = betaField(x);
+        glow += length(bx)*h*length(k2x)/max(beta0,1e-6);
+#if WARP_PHYSICS
+        peak  = max(peak,length(bx));
+        dt   += h*(E - dot(bx,p));                  // dt/dλ = E - β·p
+#endif
+    }
 
+    // Eulerian energy |p| at the far end vs. 1 at the eye: the light
+    // left there at ν_far and arrives at ν_eye, so 1 + z = ν_far/ν_eye
+    float z    = length(p) - 1.0;               // > 0: redshifted
+    float nu   = 1.0/max(1.0 + z,1e-6);         // ν_eye/ν_far: > 1 tints blue
+    vec3  tint = mix(vec3(1.0,0.45,0.25),vec3(0.45,0.65,1.0),
+                     clamp(0.5 + 2.0*(nu - 1.0),0.0,1.0));
+    vec3  col  = (trapped ? vec3(0.0) : sky(normalize(dx))*tint)
+               + vec3(1.0,0.6,0.2)*(1.0 - exp(-0.3*glow));
+    phys = vec4(peak,z,dt,float(steps));
+#if WARP_DEBUG_VIEW == 1
+    return vec3(float(steps)/255.0,0,0);
+#else
+    return col;
+#endif
+}
+
+void main(){
+    vec4 rect   = uBubble[vInst].rect;
+    vec2 extent = rect.zw - rect.xy;
+    dutyCycle   = uBubble[vInst].dutyCycle;
+    g_y         = uBubble[vInst].g_y;
+    projScale   = uProjScale*vec2(extent.x/extent.y,1.0);
+    vec2 ndc = vUV*2.0 - 1.0;
+#if WARP_SKY_ONLY
+  #if WARP_DEBUG_VIEW == 1
+    frag = vec4(0,0,0,1);
+  #else
+    frag = vec4(sky(normalize(uEyeRot*vec3(ndc*projScale,-1.0))),1.0);
+  #endif
+#elif WARP_TEMPORAL
+    ivec2 q   = ivec2(gl_FragCoord.xy) & 1;
+    int   cls = WARP_TEMPORAL==1 ? (q.x ^ q.y) : (q.x | q.y<<1);
+    vec3  d   = uEyeRot*vec3(ndc*projScale,-1.0);
+    vec4  c   = uPrevViewProj*vec4(d,0.0);           // direction: no translation
+    vec2  pn  = c.xy/max(c.w,1e-30)*vec2(extent.y/extent.x,1.0);   // → panel aspect
+    vec2  puv = pn*0.5 + 0.5;
+    bool  hit = c.w > 0.0 && all(greaterThanEqual(puv,vec2(0))) && all(lessThanEqual(puv,vec2(1)));
+    vec2  cuv = mix(rect.xy,rect.zw,puv)*0.5 + 0.5;  // panel → canvas
+    vec4  h   = hit ? texture(uHistory,cuv*uHistScale) : vec4(0);
+    if(uPhase >= 0 && cls != uPhase && h.a > 0.0){
+        frag = uMotion ? vec4(h.rgb,1.0/kTemporalMaxWeight) : h;
+        return;
+    }
+    float n = uMotion || uPhase < 0 ? 0.0 : h.a*kTemporalMaxWeight;  // prior samples
+    vec3  col = trace(ndc + uJitter*2.0/extent);
+    frag = vec4(mix(h.rgb,col,1.0/(n+1.0)),min(n+1.0,kTemporalMaxWeight)/kTemporalMaxWeight);
+#else
+    frag = vec4(trace(ndc),1.0);
+#endif
+#if WARP_PHYSICS
+    physics = phys;
+#endif
+})GLSL";
+
+//  history → canvas copy (bilinear upscale of the rendered fraction)
+static const char *kFragPresent = R"GLSL(#version 300 es
+precision mediump float;
+uniform sampler2D uSrc;
+uniform vec2 uSrcScale;
 in  vec2 vUV;
 out vec4 frag;
+void main(){ frag = vec4(texture(uSrc,vUV*uSrcScale).rgb,1.0); }
+)GLSL";
 
-// quick inline β‑field identical to C++ for visual cohesion
-vec3 betaField(vec3 x){
-    float R = sagDepth_nm*1e‑9;               // m
-    float r = length(x);
-    if(r<1e‑9) return vec3(0.);
-    float beta0 = dutyCycle*g_y;
-    float prof  = (r/R)*exp(‑(r*r)/(R*R));
-    return beta0*prof*(x/r);
+//  drawn until the first real variant has linked: sky() background only
+static const char *kFragPlaceholder = R"GLSL(#version 300 es
+precision mediump float;
+out vec4 frag;
+void main(){ frag = vec4(0.02,0.03,0.06,1.0); }
+)GLSL";
+
+//  one 4×4 fold of the physics reduction chain (see PHYSICS CHANNELS)
+static const char *kFragReduce = R"GLSL(
+precision highp float;
+uniform highp sampler2D uIn0, uIn1, uIn2, uIn3;
+uniform ivec2 uSize;                    // input texels in use
+layout(location=0) out vec4 oSum;
+layout(location=1) out vec4 oMax;
+layout(location=2) out vec4 oHistLo;    // step bins 0‑3
+layout(location=3) out vec4 oHistHi;    // step bins 4‑7
+void main(){
+    ivec2 base = ivec2(gl_FragCoord.xy)*4;
+    vec4  s = vec4(0), m = vec4(-3.0e38), h0 = vec4(0), h1 = vec4(0);
+    for(int j=0;j<4;++j) for(int i=0;i<4;++i){
+        ivec2 c = base + ivec2(i,j);
+        if(any(greaterThanEqual(c,uSize))) continue;
+#ifdef PHYS_FIRST
+        vec4 p = texelFetch(uIn0,c,0);
+        int  b = min(int(p.w*(8.0/float(kMaxSteps+1))),7);
+        s  += p;  m = max(m,p);
+        h0 += vec4(equal(ivec4(b),ivec4(0,1,2,3)));
+        h1 += vec4(equal(ivec4(b),ivec4(4,5,6,7)));
+#else
+        s  += texelFetch(uIn0,c,0);  m  = max(m,texelFetch(uIn1,c,0));
+        h0 += texelFetch(uIn2,c,0);  h1 += texelFetch(uIn3,c,0);
+#endif
+    }
+    oSum = s; oMax = m; oHistLo = h0; oHistHi = h1;
+})GLSL";
+
+//  Flow tracers (see FLOW TRACERS): kVertTracerStep advects the state
+//  buffer by transform feedback, kVertTracerDraw/kFragTracer splat it.
+//  Both vertex stages get #version, kFragConstants, kWarpBlock and
+//  kShiftKernel prepended and read bubble 0.  State is xyz in units of R, w = age.
+static const char *kVertTracerStep = R"GLSL(
+layout(location=0) in vec4 aState;
+out vec4 vState;
+uniform float uDt;                  // coordinate time this frame, R/c
+uniform uint  uSeed;                // frame counter: fresh respawn points
+float hash(uint n){
+    n = (n << 13u) ^ n;
+    n = n*(n*n*15731u + 789221u) + 1376312589u;
+    return float(n & 0x7fffffffu)*(1.0/2147483647.0);
 }
+vec3 betaField(vec3 x,float beta0){ return shiftAt(x,shiftScale(dot(x,x),beta0)); }
+void main(){
+    float beta0 = uBubble[0].dutyCycle*uBubble[0].g_y;
+    vec3  x     = aState.xyz;
+    // dx/dt = β (Eulerian flow); RK2 substeps keep h·|∇β| ≤ 0.1
+    int   n = int(clamp(ceil(uDt*abs(beta0)*10.0),1.0,8.0));
+    float h = uDt/float(n);
+    for(int i=0;i<8;++i){
+        if(i >= n) break;
+        vec3 k1 = betaField(x,beta0);
+        x += h*betaField(x + 0.5*h*k1,beta0);
+    }
+    float age  = aState.w + uDt;
+    uint  id   = uint(gl_VertexID);
+    float life = (1.0 + 3.0*hash(id*2u + 1u))/max(abs(beta0),0.25);
+    if(age > life || dot(x,x) > kSupport*kSupport){
+        // uniform in the ball s < 2.5, where |β| ≥ 1% of its peak
+        uint  k = id*3u + uSeed*2654435769u;
+        float z = 2.0*hash(k) - 1.0, phi = 6.2831853*hash(k + 1u);
+        float r = 2.5*pow(hash(k + 2u),1.0/3.0);
+        x   = r*vec3(sqrt(1.0 - z*z)*vec2(cos(phi),sin(phi)),z);
+        age = 0.0;
+    }
+    vState = vec4(x,age);
+})GLSL";
 
+static const char *kVertTracerDraw = R"GLSL(
+layout(location=0) in vec4 aState;
+uniform mat3  uEyeRot;              // as kFrag
+uniform vec3  uEyeR;                // eye in units of bubble 0's R
+uniform vec2  uProjScale;           // at panel 0's aspect
+uniform float uPointSize;
+uniform float uGain;                // additive weight, ~1/density
+out vec4 vColor;
 void main(){
-    // simple colour‑by‑β magnitude (proof‑of‑life)
-    vec3 p = vec3((vUV‑0.5)*2.0,0.0);
-    float b = length(betaField(p));
-    frag = vec4(vec3(b),1.0);
+    float beta0 = uBubble[0].dutyCycle*uBubble[0].g_y;
+    vec3  x = aState.xyz;
+    // |β|/max|β| (the peak β₀·e^{-½}/√2 sits at s = 1/√2)
+    float v = abs(beta0)*exp(-dot(x,x))*length(x)/max(0.4289*abs(beta0),1e-6);
+    float a = uGain*min(aState.w*8.0,1.0);           // fade in after a respawn
+    vColor  = vec4(mix(vec3(0.25,0.55,1.0),vec3(1.0,0.85,0.4),clamp(v,0.0,1.0))*a,a);
+    vec3  e = transpose(uEyeRot)*(x - uEyeR);          // eye space
+    gl_Position  = vec4(e.xy/uProjScale,0.0,-e.z);     // behind the eye: w < 0, clipped
+    gl_PointSize = uPointSize;
 })GLSL";
 
+static const char *kFragTracer = R"GLSL(#version 300 es
+precision mediump float;
+in  vec4 vColor;
+out vec4 frag;
+void main(){ frag = vColor; }
+)GLSL";
+
+//  transform‑feedback passes still need a fragment stage to link
+static const char *kFragDiscard = R"GLSL(#version 300 es
+precision mediump float;
+out vec4 frag;
+void main(){ frag = vec4(0); }
+)GLSL";
+
+//---------------------------------------------------------------
+//  CPU REFERENCE RENDERER  (RK45 geodesics on a tile pool)
+//---------------------------------------------------------------
+//  The answer the GPU marcher is checked against, and the still
+//  renderer for machines without WebGL2.  Camera model, sky and shading
+//  are those of trace() above.  Every ray, though, is integrated in
+//  double with Dormand–Prince 5(4) under kRefTol instead of the
+//  fixed‑tolerance RK2 march.  It also works in units of R about the
+//  bubble centre, through shift64 of the shared kernel (no 1 nm cut:
+//  the shader has none either).
+//  The image is split into kRefTile² tiles, dealt round‑robin onto one
+//  deque per worker.  A worker pops the back of its own deque and, once
+//  that is empty, steals from the front of the others.  Tiles write
+//  disjoint pixels, so the deques are the only shared state and the
+//  pool scales with the core count.  Threads need a -pthread build
+//  (with a PTHREAD_POOL_SIZE, since the caller blocks in join) or a
+//  native one; otherwise the caller renders every tile itself.
+#if defined(__EMSCRIPTEN_PTHREADS__) || !defined(__EMSCRIPTEN__)
+#define WARP_REF_THREADS 1
+#else
+#define WARP_REF_THREADS 0
+#endif
+
+constexpr int    kRefTile     = 32;       // px per tile edge
+constexpr int    kRefMaxSteps = 20000;    // accepted steps per ray
+constexpr double kRefTol      = 1e-9;     // local error per step (units of R)
+
+struct RefScene {                         // snapshot taken at the call
+    double beta0;
+    dvec3  eye;                           // units of R
+    mat3   rot;                           // camera‑to‑world
+    vec2   projScale;
+    int    w, h;
+};
+struct RefState { dvec3 x, p; };
+
+static inline RefState refDeriv(const RefScene &s,const RefState &y,double E){
+    shift64::RayRate r = shift64::rayRate(y.x,y.p,E,shift64::shiftScale(dot(y.x,y.x),s.beta0));
+    return {r.dx,r.dp};
+}
+
+static vec3 refSky(const dvec3 &d){
+    double u  = std::atan2(d.z,d.x)*(12.0/6.283185307179586);
+    double v  = std::asin(glm::clamp(d.y,-1.0,1.0))*(12.0/3.141592653589793);
+    double g  = std::max(std::fabs(u-std::floor(u)-0.5),std::fabs(v-std::floor(v)-0.5));
+    double t  = glm::clamp((g-0.46)/0.04,0.0,1.0);
+    return mix(vec3(0.02f,0.03f,0.06f),vec3(0.35f,0.55f,0.90f),float(t*t*(3.0-2.0*t)));
+}
+
+static vec3 refTrace(const RefScene &s,vec2 ndc){
+    // Dormand–Prince 5(4): a[i][j], 5th‑order weights = row 6, error = b5 - b4
+    static const double a[6][6] = {
+        {1.0/5},
+        {3.0/40,9.0/40},
+        {44.0/45,-56.0/15,32.0/9},
+        {19372.0/6561,-25360.0/2187,64448.0/6561,-212.0/729},
+        {9017.0/3168,-355.0/33,46732.0/5247,49.0/176,-5103.0/18656},
+        {35.0/384,0,500.0/1113,125.0/192,-2187.0/6784,11.0/84}};
+    static const double b5[7] = {35.0/384,0,500.0/1113,125.0/192,-2187.0/6784,11.0/84,0};
+    static const double e[7]  = {71.0/57600,0,-71.0/16695,71.0/1920,-17253.0/339200,
+                                 22.0/525,-1.0/40};
+    const double S2 = double(kSupport)*double(kSupport);
+
+    RefState y = {s.eye,normalize(dvec3(s.rot*vec3(ndc*s.projScale,-1.0f)))};
+    double k0  = s.beta0*std::exp(-dot(y.x,y.x));
+    double E   = 1.0 + k0*dot(y.x,y.p);               // |p| = 1 for the Eulerian eye
+    double beta0 = std::max(std::fabs(s.beta0),1e-6), glow = 0.0;
+
+    double xp = dot(y.x,y.p);
+    if(dot(y.x,y.x) > S2){
+        dvec3  xt   = y.x - xp*y.p;
+        double disc = S2 - dot(xt,xt);
+        if(xp >= 0.0 || disc <= 0.0) return refSky(y.p);
+        y.x += (-xp - std::sqrt(disc))*y.p;
+    }
+
+    RefState k[7];
+    k[0] = refDeriv(s,y,E);
+    double h = 0.05;
+    bool trapped = false;
+    for(int n=0;n<kRefMaxSteps;){
+        if(dot(y.x,y.x) > S2 && dot(y.x,k[0].x) > 0.0) break;
+        double pp = dot(y.p,y.p), H = double(kHorizon);
+        if(pp > H*H || pp*H*H < 1.0){ trapped = true; break; }
+
+        for(int i=1;i<7;++i){
+            RefState t = y;
+            for(int j=0;j<i;++j){ t.x += (h*a[i-1][j])*k[j].x; t.p += (h*a[i-1][j])*k[j].p; }
+            k[i] = refDeriv(s,t,E);
+        }
+        RefState ny = y, err = {dvec3(0.0),dvec3(0.0)};
+        for(int i=0;i<7;++i){
+            ny.x  += (h*b5[i])*k[i].x; ny.p  += (h*b5[i])*k[i].p;
+            err.x += (h*e[i])*k[i].x;  err.p += (h*e[i])*k[i].p;
+        }
+        double en = std::max(length(err.x),length(err.p)/std::max(length(y.p),1.0));
+        if(en <= kRefTol){                            // accept; k[6] = f(ny) (FSAL)
+            y = ny; k[0] = k[6]; ++n;
+            double kb = s.beta0*std::exp(-dot(y.x,y.x));
+            glow += std::fabs(kb)*length(y.x)*h*length(k[0].x)/beta0;
+        }
+        h *= glm::clamp(0.9*std::pow(kRefTol/std::max(en,1e-300),0.2),0.2,5.0);
+        h  = std::min(h,1.0);
+    }
+
+    double nu   = 1.0/std::max(length(y.p),1e-6);      // ν_eye/ν_far, as in kFrag
+    vec3   tint = mix(vec3(1.0f,0.45f,0.25f),vec3(0.45f,0.65f,1.0f),
+                      float(glm::clamp(0.5 + 2.0*(nu - 1.0),0.0,1.0)));
+    vec3   col  = (trapped ? vec3(0.0f) : refSky(normalize(k[0].x))*tint)
+                + vec3(1.0f,0.6f,0.2f)*float(1.0 - std::exp(-0.3*glow));
+    return col;
+}
+
+//  one deque of tile indices per worker; owners pop back, thieves front
+struct RefTilePool {
+    struct Queue { std::mutex m; std::deque<int> tiles; };
+    std::vector<Queue> q;
+    explicit RefTilePool(int workers) : q(size_t(workers)) {}
+    bool take(int self,int &tile){
+        for(size_t k=0;k<q.size();++k){
+            Queue &o = q[(size_t(self)+k)%q.size()];
+            std::lock_guard<std::mutex> lock(o.m);
+            if(o.tiles.empty()) continue;
+            if(k==0){ tile = o.tiles.back();  o.tiles.pop_back();  }
+            else    { tile = o.tiles.front(); o.tiles.pop_front(); }
+            return true;
+        }
+        return false;                          // nothing is ever re‑queued
+    }
+};
+
+static std::vector<uint8_t> gRefImage;       // RGBA8, bottom row first (glReadPixels order); page thread
+
+//  bubble 0 seen from gCam at w × h, frozen for one render
+static RefScene refScene(int w,int h){
+    RefScene s;
+    mat4 P      = gCam.proj(float(w)/float(h));
+    s.beta0     = double(gWarp.dutyCycle)*double(gWarp.g_y);
+    s.eye       = dvec3(gCam.pos)/(double(gWarp.sagDepth_nm)*1e-9);
+    s.rot       = mat3(inverse(gCam.view()));
+    s.projScale = vec2(1.0f/P[0][0],1.0f/P[1][1]);
+    s.w = w; s.h = h;
+    return s;
+}
+
+//  renders s into img (w·h·4 RGBA8); returns the wall time in ms.  Reads
+//  nothing but s, so it may run on any thread.
+static float renderReference(const RefScene &s,int threads,std::vector<uint8_t> &img){
+    Clock::time_point t0 = Clock::now();
+    int w = s.w, h = s.h;
+    img.assign(size_t(w)*size_t(h)*4,255);
+
+    int nx = (w+kRefTile-1)/kRefTile, ny = (h+kRefTile-1)/kRefTile;
+#if WARP_REF_THREADS
+    int workers = threads>0 ? threads : int(std::max(1u,std::thread::hardware_concurrency()));
+#else
+    int workers = 1; (void)threads;
+#endif
+    workers = min(workers,nx*ny);
+    RefTilePool pool(workers);
+    for(int t=0;t<nx*ny;++t) pool.q[size_t(t%workers)].tiles.push_back(t);
+
+    auto work = [&](int self){
+        int t;
+        while(pool.take(self,t)){
+            int x0 = (t%nx)*kRefTile, y0 = (t/nx)*kRefTile;
+            for(int y=y0;y<min(y0+kRefTile,h);++y)
+                for(int x=x0;x<min(x0+kRefTile,w);++x){
+                    vec2 ndc = vec2((float(x)+0.5f)/float(w),(float(y)+0.5f)/float(h))*2.0f - 1.0f;
+                    vec3 c   = refTrace(s,ndc);
+                    uint8_t *px = &img[(size_t(y)*size_t(w)+size_t(x))*4];
+                    for(int i=0;i<3;++i) px[i] = uint8_t(glm::clamp(c[i],0.0f,1.0f)*255.0f+0.5f);
+                }
+        }
+    };
+#if WARP_REF_THREADS
+    std::vector<std::thread> pool_threads;
+    for(int i=1;i<workers;++i) pool_threads.emplace_back(work,i);
+    work(0);
+    for(std::thread &th : pool_threads) th.join();
+#else
+    work(0);
+#endif
+    return std::chrono::duration<float,std::milli>(Clock::now()-t0).count();
+}
+
 //---------------------------------------------------------------
 //  OPENGL helpers
 //---------------------------------------------------------------
-static GLuint compileShader(GLenum type,const char*src){
+static GLuint compileShader(GLenum type,std::initializer_list<const char*> src){
     GLuint s = glCreateShader(type);
-    glShaderSource(s,1,&src,nullptr);
+    glShaderSource(s,GLsizei(src.size()),src.begin(),nullptr);
     glCompileShader(s);
     return s;
 }
-static GLuint createProgram(){
-    GLuint v = compileShader(GL_VERTEX_SHADER,kVert);
-    GLuint f = compileShader(GL_FRAGMENT_SHADER,kFrag);
+static GLuint createProgram(std::initializer_list<const char*> frag){
+    GLuint v = compileShader(GL_VERTEX_SHADER,{kVert});
+    GLuint f = compileShader(GL_FRAGMENT_SHADER,frag);
     GLuint p = glCreateProgram(); glAttachShader(p,v); glAttachShader(p,f);
     glLinkProgram(p); glDeleteShader(v); glDeleteShader(f); return p;
 }
+#ifdef __EMSCRIPTEN__
+//  WebGL2 getBufferSubData: part of Emscripten's GL library, not of gl3.h
+extern "C" void glGetBufferSubData(GLenum target,GLintptr offset,GLsizeiptr size,void *data);
+#else
+//  GLES 3.0 reads buffers back by mapping them
+static void glGetBufferSubData(GLenum target,GLintptr offset,GLsizeiptr size,void *data){
+    if(void *p = glMapBufferRange(target,offset,size,GL_MAP_READ_BIT)){
+        std::memcpy(data,p,size_t(size));
+        glUnmapBuffer(target);
+    }
+}
+#endif
+static bool hasGLExtension(const char *name){
+    GLint n = 0; glGetIntegerv(GL_NUM_EXTENSIONS,&n);
+    for(GLint i=0;i<n;++i)
+        if(std::strcmp((const char*)glGetStringi(GL_EXTENSIONS,i),name)==0) return true;
+    return false;
+}
 
 //---------------------------------------------------------------
-//  GLFW / GL initialisation (WebGL via Emscripten)
+//  GPU RESOURCES  (every texture and buffer, costed against a budget)
 //---------------------------------------------------------------
-static GLFWwindow* initGL(int W,int H){
-    if(!glfwInit()) return nullptr;
+//  All texture storage and buffer data goes through gpuTexture /
+//  gpuBufferData and is released with gpuFree, so gGpu always knows
+//  what the engine holds, per pool.  Fixed allocations (quad, UBO,
+//  scene target, tile list) are always made, after evicting what they
+//  can.  An optional one first asks reserve(): over the budget, reserve
+//  evicts caches in a fixed order until the request fits.
+//    1. the β LUT — the marcher falls back to exp() per sample until
+//       the table fits again
+//    2. RGBA16F temporal history — rebuilt as RGBA8 (half the bytes)
+//    3. the history itself — temporal accumulation turns off
+//  A pool never evicts itself to make room.  If nothing cheaper is
+//  left, the feature degrades: physics reads kPhysicsNoMemory, the
+//  tracer count is clamped, and a capture stops.  Counts are refreshed
+//  into FrameStats every frame.  Shader programs, FBOs and VAOs hold
+//  no storage of their own and are not counted.
+enum GpuPool : int { kPoolFixed = 0, kPoolLUT, kPoolHistory, kPoolPhysics,
+                     kPoolCapture, kPoolTracers, kPoolCount };
+constexpr size_t kGpuBudgetDefault = size_t(256) << 20;   // bytes
+
+struct GpuAlloc { GLuint name; bool buffer; int pool; size_t bytes; };
+
+static bool evictCaches(int forPool,size_t need);       // after QUALITY TIERS
+
+struct GpuResources {
+    std::vector<GpuAlloc> live;
+    size_t   pool[kPoolCount] = {};
+    size_t   total = 0, peak = 0, budget = kGpuBudgetDefault;
+    uint32_t evictions = 0;
+
+    bool fits(size_t need) const { return total + need <= budget; }
+    //  records name at bytes (replacing what it held before)
+    void track(GLuint name,bool buffer,int p,size_t bytes){
+        untrack(name,buffer);
+        live.push_back({name,buffer,p,bytes});
+        pool[p] += bytes; total += bytes; peak = std::max(peak,total);
+    }
+    void untrack(GLuint name,bool buffer){
+        for(size_t i=0;i<live.size();++i) if(live[i].name==name && live[i].buffer==buffer){
+            pool[live[i].pool] -= live[i].bytes; total -= live[i].bytes;
+            live[i] = live.back(); live.pop_back();
+            return;
+        }
+    }
+    size_t held(GLuint name,bool buffer) const {
+        for(const GpuAlloc &a : live) if(a.name==name && a.buffer==buffer) return a.bytes;
+        return 0;
+    }
+    //  true once need more bytes fit, evicting caches of other pools first
+    bool reserve(int p,size_t need){
+        return fits(need) || evictCaches(p,need);
+    }
+} gGpu;
+
+static size_t texelBytes(GLenum fmt){
+    switch(fmt){
+    case GL_RGBA32F: return 16;
+    case GL_RGBA16F: return 8;
+    default:         return 4;                // RGBA8, RG16F
+    }
+}
+//  new single‑level 2‑D texture, left bound to TEXTURE_2D
+static GLuint gpuTexture(int p,GLenum fmt,int w,int h){
+    GLuint t = 0;
+    size_t bytes = texelBytes(fmt)*size_t(w)*size_t(h);
+    gGpu.reserve(p,bytes);                    // no‑op for a pool that already reserved
+    glGenTextures(1,&t);
+    glBindTexture(GL_TEXTURE_2D,t);
+    glTexStorage2D(GL_TEXTURE_2D,1,fmt,w,h);
+    gGpu.track(t,false,p,bytes);
+    return t;
+}
+//  glBufferData on buf (0: a new buffer), which stays bound to target
+static GLuint gpuBufferData(int p,GLenum target,GLuint buf,size_t bytes,const void *data,GLenum usage){
+    size_t held = buf ? gGpu.held(buf,true) : 0;
+    if(bytes > held) gGpu.reserve(p,bytes-held);
+    if(!buf) glGenBuffers(1,&buf);
+    glBindBuffer(target,buf);
+    glBufferData(target,GLsizeiptr(bytes),data,usage);
+    gGpu.track(buf,true,p,bytes);
+    return buf;
+}
+static void gpuFree(GLuint &name,bool buffer){
+    if(!name) return;
+    gGpu.untrack(name,buffer);
+    if(buffer) glDeleteBuffers(1,&name); else glDeleteTextures(1,&name);
+    name = 0;
+}
+
+//---------------------------------------------------------------
+//  SHADER VARIANTS  (#define‑specialised kFrag, compiled on first use)
+//---------------------------------------------------------------
+//  Switches that only move on a UI toggle are baked into the program
+//  instead of being branched on per pixel, so every variant carries
+//  only its own path.  A ShaderKey is compiled the first time frame()
+//  asks for it and kept for the session; views nobody opens cost
+//  nothing.  The WarpUniforms block stays live: its fields are slider
+//  values and would otherwise force a recompile per drag.
+//
+//  Compiles never block the frame.  A new variant is only submitted;
+//  with KHR_parallel_shader_compile the driver links it off‑thread and
+//  COMPLETION_STATUS_KHR is polled once per frame, without it the
+//  status query is left for the next frame so first paint still comes
+//  first.  Until a variant is ready frame() keeps drawing the last
+//  ready one (or kFragPlaceholder at startup).  Compile/link errors
+//  are only queried after a failed link, appended to gShaderLog for
+//  getShaderLog() and echoed to the console.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+enum ShaderState : uint32_t { kShaderPending = 0, kShaderReady = 1, kShaderFailed = 2 };
+struct ShaderKey {
+    int  maxSteps = kMaxSteps;    // ray step budget (1 … kMaxSteps)
+    int  debug    = 0;            // DebugView
+    bool lut      = true;         // baked radial LUT vs. exp() per sample
+    int  temporal = 0;            // 0 off, 1 checkerboard, 2 quarter (WARP_TEMPORAL)
+    bool sky      = false;        // WARP_SKY_ONLY fill for empty tiles
+    bool physics  = false;        // WARP_PHYSICS float channels at location 1
+    int  lutShift = 0;            // LUT row of kBetaLUTSize >> lutShift texels
+    int  lutSize() const { return kBetaLUTSize >> lutShift; }
+    uint32_t pack() const {
+        return uint32_t(maxSteps) | uint32_t(debug)<<8 | uint32_t(lut)<<16 |
+               uint32_t(temporal)<<17 | uint32_t(sky)<<19 | uint32_t(physics)<<20 |
+               uint32_t(lutShift)<<21;
+    }
+    static ShaderKey unpack(uint32_t key){
+        ShaderKey k;
+        k.maxSteps = int(key&0xff); k.debug = int(key>>8&0xff); k.lut = (key>>16&1)!=0;
+        k.temporal = int(key>>17&3); k.sky = (key>>19&1)!=0; k.physics = (key>>20&1)!=0;
+        k.lutShift = int(key>>21&3);
+        return k;
+    }
+};
+struct ShaderVariant {
+    uint32_t    key  = 0;
+    GLuint      prog = 0, vs = 0, fs = 0;    // shaders live until resolved
+    ShaderState state = kShaderPending;
+    int         polls = 0;
+    GLint       locEyeRot = -1, locEyeR = -1, locProjScale = -1, locOrtho = -1;
+    GLint       locPrevViewProj = -1, locHistScale = -1, locJitter = -1,
+                locPhase = -1, locMotion = -1;    // WARP_TEMPORAL only
+};
+static std::vector<ShaderVariant> gVariants;
+static int         gStepBudget      = kMaxSteps;
+static bool        gParallelCompile = false;
+static bool        gProgramBinaries = false;  // GL_NUM_PROGRAM_BINARY_FORMATS > 0
+static bool        gShaderCacheDirty= false;  // a variant became ready since the last store
+static GLuint      gPlaceholder     = 0;
+static std::string gShaderLog;               // every failure, oldest first
+static std::mutex  gShaderLogLock;           // getShaderLog() reads it from the page thread
+
+static std::string variantDefines(const ShaderKey &k){
+    char buf[256];
+    std::snprintf(buf,sizeof(buf),
+                  "#define WARP_MAX_STEPS %d\n#define WARP_DEBUG_VIEW %d\n#define WARP_USE_LUT %d\n"
+                  "#define WARP_LUT_SIZE %d\n#define WARP_TEMPORAL %d\n#define WARP_SKY_ONLY %d\n"
+                  "#define WARP_PHYSICS %d\n",
+                  k.maxSteps,k.debug,int(k.lut),k.lutSize(),k.temporal,int(k.sky),int(k.physics));
+    return buf;
+}
+
+//  compile + link without querying anything (each query would block);
+//  salt is extra source text that only the micro‑benchmarks set, so that
+//  no driver shader cache recognises the program
+static void startVariant(ShaderVariant &v,const ShaderKey &k,const char *salt=""){
+    std::string defines = variantDefines(k);
+    v.vs   = compileShader(GL_VERTEX_SHADER,
+                           {"#version 300 es\n",salt,kFragConstants,kWarpBlock,kVertBubble});
+    v.fs   = compileShader(GL_FRAGMENT_SHADER,
+                           {"#version 300 es\n",salt,defines.c_str(),kFragConstants,kWarpBlock,kShiftKernel,kFrag});
+    v.prog = glCreateProgram();
+    glAttachShader(v.prog,v.vs); glAttachShader(v.prog,v.fs);
+    if(gProgramBinaries) glProgramParameteri(v.prog,GL_PROGRAM_BINARY_RETRIEVABLE_HINT,GL_TRUE);
+    glLinkProgram(v.prog);
+}
+
+static void appendInfoLog(std::string &out,const char *what,GLuint obj,bool isProgram){
+    GLint n = 0;
+    if(isProgram) glGetProgramiv(obj,GL_INFO_LOG_LENGTH,&n);
+    else          glGetShaderiv(obj,GL_INFO_LOG_LENGTH,&n);
+    if(n<=1) return;
+    std::string log(size_t(n),'\0');
+    if(isProgram) glGetProgramInfoLog(obj,n,nullptr,&log[0]);
+    else          glGetShaderInfoLog(obj,n,nullptr,&log[0]);
+    log.resize(std::strlen(log.c_str()));
+    out.append(what).append(": ").append(log);
+    if(out.back()!='\n') out += '\n';
+}
+
+//  linked program → locations, texture unit 0, UBO binding 0
+static void wireVariant(ShaderVariant &v){
+    v.locEyeRot    = glGetUniformLocation(v.prog,"uEyeRot");
+    v.locEyeR      = glGetUniformLocation(v.prog,"uEyeR");
+    v.locProjScale = glGetUniformLocation(v.prog,"uProjScale");
+    v.locOrtho     = glGetUniformLocation(v.prog,"uOrtho");
+    v.locPrevViewProj = glGetUniformLocation(v.prog,"uPrevViewProj");
+    v.locHistScale    = glGetUniformLocation(v.prog,"uHistScale");
+    v.locJitter       = glGetUniformLocation(v.prog,"uJitter");
+    v.locPhase        = glGetUniformLocation(v.prog,"uPhase");
+    v.locMotion       = glGetUniformLocation(v.prog,"uMotion");
+    glUseProgram(v.prog);
+    glUniform1i(glGetUniformLocation(v.prog,"uBetaLUT"),0);        // -1 without LUT: no‑op
+    glUniform1i(glGetUniformLocation(v.prog,"uHistory"),1);
+    glUniformBlockBinding(v.prog,glGetUniformBlockIndex(v.prog,"WarpUniforms"),0);
+    v.state = kShaderReady;
+    gShaderCacheDirty = true;
+}
+
+//  link has completed: check it, then wire it
+static void finishVariant(ShaderVariant &v){
+    GLint ok = 0;
+    glGetProgramiv(v.prog,GL_LINK_STATUS,&ok);
+    if(!ok){
+        char head[48];
+        std::snprintf(head,sizeof(head),"shader variant %08x failed\n",v.key);
+        std::string entry = head;
+        appendInfoLog(entry,"vertex",v.vs,false);
+        appendInfoLog(entry,"fragment",v.fs,false);
+        appendInfoLog(entry,"link",v.prog,true);
+        std::fprintf(stderr,"%s",entry.c_str());
+        { std::lock_guard<std::mutex> lock(gShaderLogLock); gShaderLog += entry; }
+        glDeleteProgram(v.prog); v.prog = 0;
+        v.state = kShaderFailed;
+    } else wireVariant(v);
+    glDeleteShader(v.vs); glDeleteShader(v.fs); v.vs = v.fs = 0;
+}
+
+//  program for k: submitted on first use, polled on every later call;
+//  wait forces a pending link to resolve now (blocking)
+static ShaderVariant shaderVariant(const ShaderKey &k,bool wait=false){
+    uint32_t key = k.pack();
+    size_t i = 0;
+    while(i<gVariants.size() && gVariants[i].key!=key) ++i;
+    if(i==gVariants.size()){
+        ShaderVariant v; v.key = key;
+        startVariant(v,k);
+        gVariants.push_back(v);
+        if(!wait) return v;
+    }
+    ShaderVariant &v = gVariants[i];
+    if(v.state==kShaderPending){
+        GLint done = wait || v.polls++ > 0;
+        if(gParallelCompile && !wait) glGetProgramiv(v.prog,GL_COMPLETION_STATUS_KHR,&done);
+        if(done) finishVariant(v);
+    }
+    return v;
+}
+
+//  enables the extension too: WebGL only honours its enum once enabled
+static void initShaderVariants(){
+    gParallelCompile = glExtension("KHR_parallel_shader_compile");
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS,&formats);
+    gProgramBinaries = formats>0;            // never on WebGL; native GLES only
+    gPlaceholder = createProgram({kFragPlaceholder});
+}
+
+//---------------------------------------------------------------
+//  SHADER CACHE  (warm start across sessions via IndexedDB)
+//---------------------------------------------------------------
+//  Every variant that has not failed is remembered in one IndexedDB
+//  record (a file natively, see storeLoad) whose name hashes all shader sources together with the GL
+//  renderer, version and GLSL strings, so an edited shader or a new
+//  driver simply misses.
+//  The record is
+//      u32 magic, u32 count,  count × { u32 key, u32 format, u32 bytes, bytes… }
+//  with bytes = 0 where the platform has no program binaries (WebGL).
+//  At startup a binary entry is loaded with glProgramBinary and is ready
+//  before the first frame.  A key‑only entry is submitted right away so
+//  it compiles in parallel before the UI asks for it.  Any entry that
+//  fails to load just falls back to a normal lazy compile.  The bench
+//  build always starts cold.
+constexpr uint32_t kShaderCacheMagic = 0x31435357;      // "WSC1"
+static const char *kShaderCacheDB    = "warp-engine";
+static char        gShaderCacheName[32];
+static bool        gShaderCacheLoaded = false;   // no store before the load resolves
+
+static uint64_t fnv1a(uint64_t h,const char *s){
+    for(; s && *s; ++s){ h ^= uint8_t(*s); h *= 0x100000001b3ull; }
+    return h;
+}
+
+//  binary entry → ready variant; false leaves the key to be compiled
+static bool restoreBinary(uint32_t key,uint32_t format,const uint8_t *bin,uint32_t n){
+    GLuint p = glCreateProgram();
+    glProgramBinary(p,format,bin,GLsizei(n));
+    GLint ok = 0; glGetProgramiv(p,GL_LINK_STATUS,&ok);
+    if(!ok){ glDeleteProgram(p); return false; }
+    ShaderVariant v; v.key = key; v.prog = p;
+    for(ShaderVariant &old : gVariants) if(old.key==key){     // pending source build
+        glDeleteProgram(old.prog); glDeleteShader(old.vs); glDeleteShader(old.fs);
+        wireVariant(v); old = v;
+        return true;
+    }
+    wireVariant(v); gVariants.push_back(v);
+    return true;
+}
+
+static void onShaderCacheLoad(const void *buf,int n){
+    const uint8_t *b = static_cast<const uint8_t*>(buf), *end = b+n;
+    uint32_t hdr[2];
+    gShaderCacheLoaded = true;
+    if(n<int(sizeof(hdr))) return;
+    std::memcpy(hdr,b,sizeof(hdr)); b += sizeof(hdr);
+    if(hdr[0]!=kShaderCacheMagic) return;
+    int binaries = 0, warmed = 0;
+    for(uint32_t i=0;i<hdr[1] && end-b>=12;++i){
+        uint32_t e[3]; std::memcpy(e,b,sizeof(e)); b += sizeof(e);
+        if(uint32_t(end-b)<e[2]) break;
+        const uint8_t *bin = b; b += e[2];
+        ShaderKey k = ShaderKey::unpack(e[0]);
+        if(k.pack()!=e[0] || k.maxSteps<1 || k.maxSteps>kMaxSteps) continue;
+        bool known = false, pending = false;
+        for(const ShaderVariant &v : gVariants)
+            if(v.key==e[0]){ known = true; pending = v.state==kShaderPending; }
+        if(known && !pending) continue;
+        if(e[2] && gProgramBinaries && restoreBinary(e[0],e[1],bin,e[2])){ ++binaries; continue; }
+        if(!known){ shaderVariant(k); ++warmed; }     // submit now, poll on use
+    }
+    gShaderCacheDirty = false;               // what we have now is what is stored
+    std::printf("shader cache: %d binary, %d prewarmed\n",binaries,warmed);
+}
+static void onShaderCacheMiss(){ gShaderCacheLoaded = true; }
+
+void loadShaderCache(){
+    const GLenum driver[] = {GL_RENDERER,GL_VERSION,GL_SHADING_LANGUAGE_VERSION};
+    uint64_t h = 0xcbf29ce484222325ull;
+    for(const char *src : {kVert,kVertBubble,kWarpBlock,kFragConstants,kShiftKernel,kFrag,
+                           kFragPlaceholder,kFragPresent})
+        h = fnv1a(h,src);
+    for(GLenum e : driver) h = fnv1a(h,(const char*)glGetString(e));
+    std::snprintf(gShaderCacheName,sizeof(gShaderCacheName),"shaders-%016llx",
+                  (unsigned long long)h);
+#ifdef WARP_BENCH
+    gShaderCacheLoaded = true;               // cold starts only; never stored
+#else
+    storeLoad(kShaderCacheDB,gShaderCacheName,onShaderCacheLoad,onShaderCacheMiss);
+#endif
+}
+
+//  per‑frame: rewrite the record once a new variant has become ready
+void storeShaderCache(){
+    if(!gShaderCacheDirty || !gShaderCacheLoaded) return;
+    gShaderCacheDirty = false;
+#ifndef WARP_BENCH
+    std::vector<uint8_t> blob(8);
+    uint32_t count = 0;
+    auto put = [&](uint32_t w){ const uint8_t *p = (const uint8_t*)&w; blob.insert(blob.end(),p,p+4); };
+    for(const ShaderVariant &v : gVariants){
+        if(v.state==kShaderFailed) continue;   // pending: prewarmed, keep the key
+        GLint  n = 0;
+        GLenum format = 0;
+        if(gProgramBinaries && v.state==kShaderReady) glGetProgramiv(v.prog,GL_PROGRAM_BINARY_LENGTH,&n);
+        put(v.key); size_t at = blob.size(); put(0); put(0);
+        if(n>0){
+            blob.resize(blob.size()+size_t(n));
+            glGetProgramBinary(v.prog,n,&n,&format,blob.data()+at+8);
+            blob.resize(at+8+size_t(n));
+        }
+        std::memcpy(blob.data()+at,&format,4);
+        std::memcpy(blob.data()+at+4,&n,4);
+        ++count;
+    }
+    std::memcpy(blob.data(),&kShaderCacheMagic,4);
+    std::memcpy(blob.data()+4,&count,4);
+    storeSave(kShaderCacheDB,gShaderCacheName,blob.data(),int(blob.size()));   // copies the bytes
+#endif
+}
+
+//---------------------------------------------------------------
+//  GLFW / GL initialisation (WebGL via Emscripten, or native GLES 3)
+//---------------------------------------------------------------
+static int gW=800,gH=600;                  // canvas drawing buffer in pixels
+static int gTW=0,gTH=0;                    // render targets, ≥ gW × gH (CANVAS SIZE)
+#ifdef WARP_OFFSCREEN
+//  GLFW cannot drive an OffscreenCanvas from a worker, so the worker
+//  build talks to the html5 WebGL API directly; presentation happens
+//  implicitly each time the main‑loop callback returns.
+static EMSCRIPTEN_WEBGL_CONTEXT_HANDLE gCtx = 0;
+static bool initGL(int W,int H){
+    EmscriptenWebGLContextAttributes a;
+    emscripten_webgl_init_context_attributes(&a);
+    a.majorVersion = 2; a.minorVersion = 0;
+    a.alpha = EM_FALSE; a.depth = EM_FALSE; a.antialias = EM_FALSE;
+    emscripten_set_canvas_element_size("#canvas",W,H);
+    gCtx = emscripten_webgl_create_context("#canvas",&a);
+    return gCtx>0 && emscripten_webgl_make_context_current(gCtx)==EMSCRIPTEN_RESULT_SUCCESS;
+}
+#else
+static GLFWwindow *gWin=nullptr;
+static bool initGL(int W,int H){
+    if(!glfwInit()) return false;
     glfwWindowHint(GLFW_CLIENT_API,GLFW_OPENGL_ES_API);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,0);
-    GLFWwindow* win = glfwCreateWindow(W,H,"Warp",nullptr,nullptr);
-    glfwMakeContextCurrent(win);
-    return win;
+    gWin = glfwCreateWindow(W,H,"Warp",nullptr,nullptr);
+    if(!gWin) return false;
+    glfwMakeContextCurrent(gWin);
+#if !defined(__EMSCRIPTEN__) && defined(WARP_BENCH)
+    glfwSwapInterval(0);                     // timed frames must not wait for vsync
+#elif !defined(__EMSCRIPTEN__)
+    glfwSwapInterval(1);                     // the browser's rAF pacing
+#endif
+    return true;
+}
+#endif
+
+//  PLATFORM LAYER, browser: html5 / WebGL / IndexedDB, one #canvas
+#ifdef __EMSCRIPTEN__
+static bool glExtension(const char *name){
+    return emscripten_webgl_enable_extension(emscripten_webgl_get_current_context(),name);
+}
+static void loopRun(void (*frame)()){ emscripten_set_main_loop(frame,0,1); }
+static void loopPause(){ emscripten_pause_main_loop(); }
+static void loopResume(){ emscripten_resume_main_loop(); }
+static void loopExit(int code){ emscripten_cancel_main_loop(); emscripten_force_exit(code); }
+static bool canvasCssSize(double &w,double &h){
+    return emscripten_get_element_css_size("#canvas",&w,&h)==EMSCRIPTEN_RESULT_SUCCESS && w>=1 && h>=1;
+}
+static double canvasPixelRatio(){ return emscripten_get_device_pixel_ratio(); }
+//  a canvas without a CSS size of its own lays out at its width / height
+//  attributes, so each fit would grow it by the DPR: if the attributes
+//  moved the CSS box, it is pinned at the size measured before
+static void   canvasSetSize(int w,int h){
+    double cw = 0, ch = 0, nw = 0, nh = 0;
+    bool   had = canvasCssSize(cw,ch);
+    emscripten_set_canvas_element_size("#canvas",w,h);
+    if(had && canvasCssSize(nw,nh) && (nw!=cw || nh!=ch))
+        emscripten_set_element_css_size("#canvas",cw,ch);
+}
+static void   canvasOnResize(void (*f)()){
+    emscripten_set_resize_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW,reinterpret_cast<void*>(f),EM_FALSE,
+        [](int,const EmscriptenUiEvent*,void *f)->EM_BOOL{ reinterpret_cast<void(*)()>(f)(); return EM_FALSE; });
+}
+static void (*gStoreLoaded)(const void*,int) = nullptr;
+static void (*gStoreMissing)() = nullptr;
+static void storeLoad(const char *db,const char *key,void (*loaded)(const void*,int),void (*missing)()){
+    gStoreLoaded = loaded; gStoreMissing = missing;
+    emscripten_idb_async_load(db,key,nullptr,
+                              [](void*,void *data,int n){ gStoreLoaded(data,n); },
+                              [](void*){ gStoreMissing(); });
+}
+static void storeSave(const char *db,const char *key,const void *data,int n){
+    emscripten_idb_async_store(db,key,const_cast<void*>(data),n,nullptr,nullptr,nullptr);
+}
+#else
+//  PLATFORM LAYER, native: the GLFW window is the canvas.  Its
+//  framebuffer is the drawing buffer at ratio 1 (the OS already
+//  applied the display scale) and the resolution governor does the
+//  rest.  A parked loop sleeps in glfwWaitEvents() until an event or a
+//  requestRedraw() wakes it.  Records are files <db>-<key>.bin in
+//  $WARP_STORE_DIR or the working directory.
+static bool gLoopParked = false, gLoopDone = false;
+static int  gLoopExit   = 0;
+static void (*gOnResize)() = nullptr;
+
+static bool glExtension(const char *name){
+    return hasGLExtension((std::string("GL_")+name).c_str());
+}
+static void loopRun(void (*frame)()){
+    while(!gLoopDone && !glfwWindowShouldClose(gWin)){
+        if(gLoopParked) glfwWaitEvents();
+        if(!gLoopParked) frame();
+    }
+    glfwTerminate();
+    std::exit(gLoopExit);
+}
+static void loopPause(){ gLoopParked = true; }
+static void loopResume(){ gLoopParked = false; glfwPostEmptyEvent(); }
+static void loopExit(int code){ gLoopExit = code; gLoopDone = true; }
+static bool canvasCssSize(double &w,double &h){
+    int fw = 0, fh = 0;
+    glfwGetFramebufferSize(gWin,&fw,&fh);
+    w = fw; h = fh;
+    return fw>0 && fh>0;                     // 0 × 0 while minimised
+}
+static double canvasPixelRatio(){ return 1.0; }
+static void   canvasSetSize(int,int){}       // the framebuffer follows the window
+static void   canvasOnResize(void (*f)()){
+    gOnResize = f;
+    glfwSetFramebufferSizeCallback(gWin,[](GLFWwindow*,int,int){ gOnResize(); });
+}
+static std::string storePath(const char *db,const char *key){
+    const char *dir = std::getenv("WARP_STORE_DIR");
+    return std::string(dir ? dir : ".") + "/" + db + "-" + key + ".bin";
+}
+static void storeLoad(const char *db,const char *key,void (*loaded)(const void*,int),void (*missing)()){
+    std::FILE *f = std::fopen(storePath(db,key).c_str(),"rb");
+    if(!f){ missing(); return; }
+    std::vector<uint8_t> b;
+    uint8_t tmp[1<<16];
+    for(size_t n; (n = std::fread(tmp,1,sizeof(tmp),f))>0;) b.insert(b.end(),tmp,tmp+n);
+    std::fclose(f);
+    loaded(b.data(),int(b.size()));
+}
+static void storeSave(const char *db,const char *key,const void *data,int n){
+    if(std::FILE *f = std::fopen(storePath(db,key).c_str(),"wb")){
+        std::fwrite(data,1,size_t(n),f);
+        std::fclose(f);
+    }
+}
+#endif
+
+//---------------------------------------------------------------
+//  β‑FIELD LUT  (radial, re‑baked only when the field shape changes)
+//---------------------------------------------------------------
+//  β depends on (dutyCycle, g_y, sagDepth_nm) alone and is radial, so
+//  the marcher samples a 1‑D table over u = s²/kSupport² (s = r/R)
+//  instead of paying an exp + length per sample.  Texel i holds
+//      R: β₀·e^{-s²}      (β = R‑channel · x/R)
+//      G: step size / R   (same heuristic the analytic path uses)
+//  RG16F keeps hardware linear filtering available on every WebGL2.
+//  Size and step constants come from WARP_MARCH_CONSTANTS.  Row i of
+//  the kBetaLUTSize × kMaxBubbles texture belongs to bubble i; all rows
+//  in use are re‑baked whenever gShapeGen moves.  Quality tiers bake
+//  only the first kBetaLUTSize >> gLUTShift texels of each row (the
+//  variant's WARP_LUT_SIZE), so a cheaper table needs no new texture.
+//  setBetaLUT() is the user's choice.  An eviction (GPU RESOURCES) only
+//  suspends it, and the table is baked again once it fits the budget.
+
+constexpr size_t kBetaLUTBytes = 4*size_t(kBetaLUTSize)*kMaxBubbles;   // RG16F
+static GLuint gBetaLUT    = 0;
+static bool   gUseBetaLUT = true;           // setBetaLUT()
+static bool   gLUTEvicted = false;          // table given up for the budget
+static int    gLUTShift   = 0;              // requested row length: kBetaLUTSize >> gLUTShift
+static uint32_t gLUTGen   = ~0u;            // gShapeGen of the last bake
+static int    gLUTBaked   = -1;             // gLUTShift of the last bake
+
+//  the texture itself, made before the frame picks its variant so a
+//  budget that refuses it turns the variant analytic in the same frame
+static bool allocBetaLUT(){
+    if(gBetaLUT) return true;
+    if(!gGpu.reserve(kPoolLUT,kBetaLUTBytes)){ gLUTEvicted = true; return false; }
+    gBetaLUT = gpuTexture(kPoolLUT,GL_RG16F,kBetaLUTSize,kMaxBubbles);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+    gLUTGen = ~0u;
+    return true;
+}
+
+void bakeBetaLUT(int shift){
+    int n = kBetaLUTSize >> shift;
+    std::vector<float> texels(2*kBetaLUTSize*gBubbleCount);
+    for(int b=0;b<gBubbleCount;++b){
+        float beta0 = gBubbles[b].dutyCycle*gBubbles[b].g_y;
+        float *row  = &texels[2*kBetaLUTSize*b];
+        for(int i=0;i<n;++i){
+            float s2 = kSupport*kSupport*float(i)/float(n-1);
+            float k  = shift32::shiftScale(s2,beta0);
+            row[2*i+0] = k;
+            row[2*i+1] = shift32::stepScale(s2,k);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D,gBetaLUT);
+    glTexSubImage2D(GL_TEXTURE_2D,0,0,0,kBetaLUTSize,gBubbleCount,GL_RG,GL_FLOAT,texels.data());
+    gLUTGen = gShapeGen; gLUTBaked = shift;
+}
+
+//  first cache to go under memory pressure (see GPU RESOURCES)
+void evictBetaLUT(){
+    gpuFree(gBetaLUT,false);
+    gLUTEvicted = true; gLUTGen = ~0u;
+}
+
+//  true if variants built now sample the LUT
+static bool betaLUTActive(){ return gUseBetaLUT && !gLUTEvicted; }
+
+//  once per frame, before the render targets: an evicted table comes
+//  back once it fits without evicting anything in turn
+static void admitBetaLUT(){
+    if(gLUTEvicted && gGpu.fits(kBetaLUTBytes)) gLUTEvicted = false;
+    if(betaLUTActive()) allocBetaLUT();
+}
+
+//  cheap per‑frame check; the bake itself only runs on a shape change
+//  or when the drawn variant samples a different row length
+void syncBetaLUT(int shift){
+    if(!betaLUTActive() || !gBetaLUT) return;
+    if(gLUTGen!=gShapeGen || gLUTBaked!=shift) bakeBetaLUT(shift);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D,gBetaLUT);
+}
+
+//---------------------------------------------------------------
+//  MULTI‑BUBBLE PANELS  (one instanced draw, one UBO upload)
+//---------------------------------------------------------------
+//  Design points are compared side by side: instance i of the marcher
+//  draw reads uBubble[i] and places its quad in gBubbleRect[i], with
+//  the camera re‑fitted to that panel's aspect.  Each pixel still traces
+//  exactly one bubble, so N panels cost their pixels and nothing else.
+//  setBubbleCount() lays the panels out on a near‑square grid (row 0 at
+//  the top); setBubbleRect() overrides single panels.  New bubbles
+//  start as copies of bubble 0.
+void layoutBubbles(int n){
+    int cols = int(std::ceil(std::sqrt(float(n)))), rows = (n+cols-1)/cols;
+    for(int i=0;i<n;++i){
+        float x0 = float(i%cols)/float(cols), y1 = 1.f - float(i/cols)/float(rows);
+        gBubbleRect[i] = vec4(x0,y1-1.f/float(rows),x0+1.f/float(cols),y1)*2.f - 1.f;
+    }
 }
 
 //---------------------------------------------------------------
 //  UNITY QUAD (NDC)
 //---------------------------------------------------------------
-static GLuint gVAO=0;
+static GLuint gVAO=0, gQuadVBO=0;
 void initQuad(){
-    float v[12]={‑1,-1, 1,-1, 1, 1,  ‑1,-1, 1, 1, ‑1, 1};
-    GLuint vbo; glGenVertexArrays(1,&gVAO); glGenBuffers(1,&vbo);
+    float v[12]={-1,-1, 1,-1, 1, 1,  -1,-1, 1, 1, -1, 1};
+    glGenVertexArrays(1,&gVAO);
     glBindVertexArray(gVAO);
-    glBindBuffer(GL_ARRAY_BUFFER,vbo);
-    glBufferData(GL_ARRAY_BUFFER,sizeof(v),v,GL_STATIC_DRAW);
+    gQuadVBO = gpuBufferData(kPoolFixed,GL_ARRAY_BUFFER,0,sizeof(v),v,GL_STATIC_DRAW);
     glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,0,(void*)0);
     glEnableVertexAttribArray(0);
 }
 
 //---------------------------------------------------------------
-//  UBO update every frame
+//  UBO update (only when gWarp's generation moves)
 //---------------------------------------------------------------
+//  One upload carries every bubble: the block is BubbleGPU[kMaxBubbles].
+//  The buffer is a ring of kUBORing aligned slots.  Each upload goes to
+//  the next slot and is bound with glBindBufferRange, so the write never
+//  targets the range the previous frames' draws are still reading.
+constexpr int kUBORing = 3;               // ≥ frames the driver keeps in flight
+static GLsizeiptr gUBOStride = 0;
+static int        gUBOSlot   = 0;
+static uint32_t   gUBOGen    = ~0u;        // generation currently on the GPU
+
+void initUBO(){
+    GLint align = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,&align);
+    gUBOStride = (GLsizeiptr(sizeof(BubbleGPU)*kMaxBubbles) + align-1)/align*align;
+    gUBO = gpuBufferData(kPoolFixed,GL_UNIFORM_BUFFER,0,size_t(kUBORing*gUBOStride),nullptr,GL_DYNAMIC_DRAW);
+}
+
 void syncUBO(){
+    if(gUBOGen==gWarpGen) return;
+    gUBOSlot = (gUBOSlot+1)%kUBORing;
+    GLintptr off = gUBOSlot*gUBOStride;
+    BubbleGPU block[kMaxBubbles] = {};
+    for(int i=0;i<gBubbleCount;++i){ block[i].rect = gBubbleRect[i]; block[i].w = gBubbles[i]; }
     glBindBuffer(GL_UNIFORM_BUFFER,gUBO);
-    glBufferSubData(GL_UNIFORM_BUFFER,0,sizeof(WarpUniforms),&gWarp);
+    glBufferSubData(GL_UNIFORM_BUFFER,off,sizeof(block),block);
+    glBindBufferRange(GL_UNIFORM_BUFFER,0,gUBO,off,sizeof(block));
+    gUBOGen = gWarpGen;
+}
+
+//---------------------------------------------------------------
+//  DYNAMIC RESOLUTION  (internal target + frame‑time governor)
+//---------------------------------------------------------------
+//  The marcher renders into the lower‑left scale·W × scale·H corner of
+//  a gTW × gTH target (at least canvas sized, see CANVAS SIZE), which is then blitted (bilinear) over the
+//  canvas.  Changing the scale only changes the viewport, so the
+//  governor can move it every frame without reallocating anything.
+//  The governor watches the smoothed frame‑to‑frame interval: missing
+//  the budget by >15 % drops the scale 10 %, and 30 calm frames in a
+//  row raise it 5 % again.  Pixel cost goes with scale².  Ticks that
+//  render nothing restart the interval, and work done outside the draw
+//  (a STILL RENDERING slice) is taken out of it, so neither reads as a
+//  slow GPU.  The interval also holds the vsync wait, and a 30–50 Hz
+//  display or a throttled rAF never reaches a 60 Hz target.  Where the
+//  GPU timer has results the governor reads the draw time instead,
+//  which holds no wait.  Otherwise the first miss is a probe: the scale
+//  drops to minScale for kResProbe frames (a small step could stay
+//  within the same vsync).  If the interval has not shrunk, the display
+//  sets the pace: the old scale comes back and that interval becomes
+//  the budget's floor (refreshMs) until frames run well under it again.
+//  If it has, misses are draw cost and the 10 % steps take over until
+//  the full scale is calm again.
+constexpr int kResProbe = 12;              // frames to judge a cut by
+struct ResGovernor {
+    float targetMs = 1000.f/60.f;          // ≤ 0 → fixed at maxScale
+    float minScale = 0.35f, maxScale = 1.0f;
+    float scale    = 1.0f;
+    float avgMs    = 0.0f;
+    int   calm     = 0;
+    float refreshMs = 0.f;                 // learned interval floor, 0 = none
+    float probeMs = 0.f, probeScale = 0.f; // avgMs and scale before the probe
+    int   probe   = 0;                     // frames left to judge it
+    bool  drawBound = false;               // a probe showed the misses are draw cost
+    Clock::time_point last{};
+
+    void restart(){ last = Clock::time_point{}; }   // after an idle gap
+    //  once per rendered frame; asideMs: time since the last one not
+    //  spent rendering, gpuMs: the latest GPU draw time (< 0: none)
+    void tick(float asideMs = 0.f,float gpuMs = -1.f){
+        Clock::time_point now = Clock::now(), prev = last;
+        last = now;
+        if(targetMs <= 0.f){ scale = maxScale; return; }
+        float ms;
+        if(gpuMs >= 0.f){ ms = gpuMs; refreshMs = 0.f; }          // no vsync in it
+        else if(prev != Clock::time_point{})
+            ms = std::chrono::duration<float,std::milli>(now-prev).count() - asideMs;
+        else return;
+        avgMs = avgMs > 0.f ? mix(avgMs,ms,0.1f) : ms;
+        if(refreshMs > 0.f && avgMs < 0.8f*refreshMs) refreshMs = 0.f;   // faster display
+        float budget = max(targetMs,refreshMs);
+        if(probe){
+            if(--probe) return;
+            if(avgMs > 0.95f*probeMs){ refreshMs = avgMs; scale = probeScale; }   // vsync paced
+            else { drawBound = true; scale = max(minScale,probeScale*0.9f); }
+            avgMs = max(targetMs,refreshMs); calm = 0;
+        } else if(avgMs > 1.15f*budget){
+            if(scale > minScale && gpuMs < 0.f && !drawBound){
+                probeMs = avgMs; probeScale = scale; probe = kResProbe;
+                scale = minScale; avgMs = 0.f;
+            } else if(scale > minScale){
+                scale = max(minScale,scale*0.9f); avgMs = budget;   // GPU results lag a frame or two
+            }
+            calm = 0;
+        } else if(avgMs < 1.05f*budget && ++calm >= 30){
+            if(scale >= maxScale) drawBound = false;
+            scale = min(maxScale,scale*1.05f); calm = 0;
+        }
+    }
+} gRes;
+
+static GLuint gSceneFBO = 0, gSceneTex = 0;
+
+void initSceneTarget(int W,int H){
+    gSceneTex = gpuTexture(kPoolFixed,GL_RGBA8,W,H);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glGenFramebuffers(1,&gSceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER,gSceneFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,gSceneTex,0);
+    glBindFramebuffer(GL_FRAMEBUFFER,0);
+}
+
+//---------------------------------------------------------------
+//  TEMPORAL ACCUMULATION  (partial tracing into a reprojected history)
+//---------------------------------------------------------------
+//  With fraction 2 or 4 the marcher traces only that share of the
+//  pixels per frame (WARP_TEMPORAL in kFrag).  It renders into one of
+//  two gTW × gTH history targets while reading the other, and a copy
+//  pass then presents the result; the render scale is carried along as
+//  uHistScale like gSceneFBO's sub‑viewport.  Targets are RGBA16F when
+//  EXT_color_buffer_float exists and the GPU budget has room.  The
+//  RGBA8 fallback rounds the small
+//  1/n blend steps away, so a converged image there can sit a few
+//  levels off.  An eviction (GPU RESOURCES) narrows or suspends the
+//  history but leaves fraction, the setTemporal() / tier choice, alone;
+//  ready() brings RGBA16F and the targets back once gGpu.fits() them.  The history is dropped and the next frame traces
+//  every pixel when the field shape (gShapeGen), the render scale,
+//  the shader variant or the panel layout changes.  Camera motion only
+//  resets the sample weights.
+static float halton(uint32_t i,uint32_t b){
+    float f = 1.f, r = 0.f;
+    for(; i; i /= b){ f /= float(b); r += f*float(i%b); }
+    return r;
+}
+
+struct Temporal {
+    int      fraction = 1;           // 1 = off, 2 = checkerboard, 4 = 2×2 quads
+    GLuint   tex[2] = {}, fbo[2] = {};
+    GLuint   present = 0;
+    GLint    locSrcScale = -1;
+    bool     halfFloat = false, valid = false;
+    bool     narrow = false;         // RGBA8 only: RGBA16F was evicted (GPU RESOURCES)
+    bool     suspended = false;      // targets evicted or over budget: off until they fit
+    int      cur = 0;
+    uint32_t frame = 0, still = 0;   // frames accumulated / since the last motion
+    uint32_t key = 0;                // variant that wrote the history
+    uint32_t shape = ~0u;            // gShapeGen it was traced with
+    vec2     histScale{0.f};
+    mat4     prevViewProj{0.f};
+
+    int  shaderMode() const { return fraction==4 ? 2 : fraction==2 ? 1 : 0; }
+    bool converging() const { return valid && still < uint32_t(fraction*kTemporalMaxWeight); }
+    void invalidate(){ valid = false; }
+
+    //  targets for the first frame that wants them; false: over budget
+    bool init(int W,int H){
+        bool   wide = !narrow && glExtension("EXT_color_buffer_float");
+        size_t px   = 2*size_t(W)*size_t(H);
+        if(wide && !gGpu.reserve(kPoolHistory,8*px)) wide = false;
+        if(!wide && !gGpu.reserve(kPoolHistory,4*px)) return false;
+        halfFloat = wide;
+        glGenFramebuffers(2,fbo);
+        for(int i=0;i<2;++i){
+            tex[i] = gpuTexture(kPoolHistory,halfFloat ? GL_RGBA16F : GL_RGBA8,W,H);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+            glBindFramebuffer(GL_FRAMEBUFFER,fbo[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,tex[i],0);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+        if(!present){
+            present     = createProgram({kFragPresent});
+            locSrcScale = glGetUniformLocation(present,"uSrcScale");
+            glUseProgram(present);
+            glUniform1i(glGetUniformLocation(present,"uSrc"),1);
+        }
+        valid = false;
+        return true;
+    }
+    void release(){
+        for(GLuint &t : tex) gpuFree(t,false);
+        glDeleteFramebuffers(2,fbo); fbo[0] = fbo[1] = 0;
+        valid = false;
+    }
+    //  true if this frame accumulates; makes the targets on first use,
+    //  sits out while they do not fit, and widens them again when
+    //  RGBA16F fits (only the extra 4 bytes per texel are new)
+    bool ready(){
+        if(fraction<=1) return false;
+        size_t px = 2*size_t(gTW)*size_t(gTH);
+        if(tex[0] && narrow && gGpu.fits(4*px)){          // set only where RGBA16F worked
+            release(); narrow = false;
+        }
+        if(!tex[0]){
+            if(suspended && !gGpu.fits(4*px)) return false;
+            suspended = !init(gTW,gTH);
+        }
+        return !suspended;
+    }
+    GLuint target() const { return fbo[cur]; }
+
+    //  per frame, with sv's program in use and an rw × rh viewport
+    void bind(const ShaderVariant &sv,int rw,int rh){
+        mat4 vp    = gCam.proj(float(gW)/float(gH))*gCam.view();
+        vec2 hs    = vec2(float(rw)/float(gTW),float(rh)/float(gTH));
+        if(sv.key!=key || hs!=histScale || shape!=gShapeGen) valid = false;
+        bool motion = !valid || vp!=prevViewProj;
+        if(motion) still = 0;
+        uint32_t n = still/uint32_t(fraction) + 1;      // samples per class so far
+        vec2 j = motion ? vec2(0.f)
+                        : vec2(halton(n,2)-0.5f,halton(n,3)-0.5f)*2.f/vec2(float(rw),float(rh));
+        glUniformMatrix4fv(sv.locPrevViewProj,1,GL_FALSE,value_ptr(valid ? prevViewProj : vp));
+        glUniform2f(sv.locHistScale,hs.x,hs.y);
+        glUniform2f(sv.locJitter,j.x,j.y);
+        glUniform1i(sv.locPhase,valid ? int(frame%uint32_t(fraction)) : -1);
+        glUniform1i(sv.locMotion,motion);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D,tex[cur^1]);
+        glActiveTexture(GL_TEXTURE0);
+        key = sv.key; histScale = hs; prevViewProj = vp; shape = gShapeGen;
+        valid = true; ++frame; ++still;
+    }
+
+    //  copy the new history over the whole canvas, then flip
+    void presentTo(int W,int H){
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+        glViewport(0,0,W,H);
+        glUseProgram(present);
+        glUniform2f(locSrcScale,histScale.x,histScale.y);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D,tex[cur]);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(gVAO);
+        glDrawArrays(GL_TRIANGLES,0,6);
+        cur ^= 1;
+    }
+} gTemporal;
+
+//---------------------------------------------------------------
+//  QUALITY TIERS  (one switch for resolution, steps, LUT, temporal)
+//---------------------------------------------------------------
+//  The same build serves workstations and Chromebooks.  setQuality(t)
+//  sets the resolution governor bounds, the step budget, the LUT row
+//  length and the temporal fraction in one go.  All of them are live
+//  state or ShaderKey bits, so nothing is reloaded and the GL context
+//  stays.  The first setQuality() submits every tier's variant, so
+//  later switches find them linked.  kQualityAuto waits for the top
+//  tier's variant and then times a few full‑canvas frames of it
+//  (runQualityBench in MAIN RENDER LOOP).  It then picks the best tier
+//  whose cost estimate, scale² · steps / fraction, fits kQualityBudget
+//  of a 60 Hz frame.  The individual setters stay available; using one
+//  turns the tier into kQualityCustom.
+enum Quality : int { kQualityCustom = -1, kQualityLow = 0, kQualityMedium, kQualityHigh,
+                     kQualityUltra, kQualityAuto };
+struct QualityPreset {
+    float minScale, maxScale, targetMs;   // governor (targetMs ≤ 0: pinned)
+    int   steps, lutShift, fraction;      // step budget, LUT row shift, temporal
+};
+static const QualityPreset kQualityPresets[kQualityAuto] = {
+    { 0.35f, 0.6f,  1000.f/60.f,  64, 2, 4 },    // low:    128‑texel LUT, ¼ traced
+    { 0.5f,  0.85f, 1000.f/60.f, 128, 1, 2 },    // medium: 256, checkerboard
+    { 0.6f,  1.0f,  1000.f/60.f, 160, 0, 1 },    // high
+    { 1.0f,  1.0f,  0.f,   kMaxSteps, 0, 1 },    // ultra:  native, full budget
+};
+constexpr float kQualityBudget      = 0.7f;   // share of 16.7 ms the estimate may use
+constexpr int   kQualityBenchFrames = 5;      // timed after one warm‑up draw
+constexpr float kQualityBenchMaxMs  = 250.f;  // stop early on slow machines
+
+struct QualityState {
+    int   tier    = kQualityCustom;
+    bool  bench   = false;                // auto: runQualityBench() owed
+    bool  warmed  = false;                // every tier's variant submitted
+    float benchMs = 0.f;                  // median top‑tier frame, 0 = not run
+
+    void apply(int t){
+        const QualityPreset &q = kQualityPresets[t];
+        gRes.minScale = q.minScale; gRes.maxScale = q.maxScale; gRes.targetMs = q.targetMs;
+        gRes.scale    = glm::clamp(gRes.scale,q.minScale,q.maxScale);
+        gStepBudget   = q.steps;
+        gLUTShift     = q.lutShift;
+        if(gTemporal.fraction!=q.fraction){ gTemporal.fraction = q.fraction; gTemporal.invalidate(); }
+        tier = t;
+    }
+    //  highest tier whose estimate from benchMs fits the budget
+    int pick() const {
+        const QualityPreset &top = kQualityPresets[kQualityUltra];
+        for(int t=kQualityUltra;t>kQualityLow;--t){
+            const QualityPreset &q = kQualityPresets[t];
+            float est = benchMs*q.maxScale*q.maxScale*float(q.steps)/float(top.steps)/float(q.fraction);
+            if(est <= kQualityBudget*1000.f/60.f) return t;
+        }
+        return kQualityLow;
+    }
+} gQuality;
+
+//  GPU RESOURCES' eviction order; true once need more bytes fit
+static bool evictCaches(int forPool,size_t need){
+    if(forPool!=kPoolLUT && gBetaLUT){
+        evictBetaLUT(); ++gGpu.evictions;
+        if(gGpu.fits(need)) return true;
+    }
+    if(forPool==kPoolHistory) return false;
+    if(gTemporal.tex[0] && gTemporal.halfFloat){      // ready() rebuilds it as RGBA8
+        gTemporal.release(); gTemporal.narrow = true; ++gGpu.evictions;
+        if(gGpu.fits(need)) return true;
+    }
+    if(gTemporal.tex[0] || (gTemporal.fraction>1 && !gTemporal.suspended)){
+        if(gTemporal.tex[0]) ++gGpu.evictions;
+        gTemporal.release(); gTemporal.suspended = true;
+        if(gGpu.fits(need)) return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------
+//  EMPTY‑SPACE SKIPPING  (screen tiles vs. the β support sphere)
+//---------------------------------------------------------------
+//  β is zero to float precision outside r = kSupport·R, so a ray that
+//  misses that sphere only needs sky().  Each kTileSize² tile of the
+//  render viewport is tested on the CPU: the cone around its centre ray
+//  that holds all four corner rays is checked against the cone the
+//  sphere subtends from the eye.  The live tiles go first in one vertex
+//  buffer and the dead ones after, so the marcher draws the first range
+//  and the WARP_SKY_ONLY variant fills the second.  Tile corners are
+//  panel‑local NDC, and their rays use the panel's aspect, as projScale
+//  in kFrag does.  The list is rebuilt only when the camera, the
+//  viewport, R or panel 0's rect changes.  With the eye
+//  inside the support every tile is live, and the frame keeps its
+//  single full‑screen draw.  Only single‑bubble frames are tiled.
+constexpr int kTileSize = 16;
+struct TileSkip {
+    bool   enabled = true;
+    GLuint vao = 0, vbo = 0;
+    int    live = 0, total = 0;      // tiles in the current list
+    mat4   view{0.f};                // inputs the list was built from
+    float  fov = 0.f, R = 0.f;
+    int    w = 0, h = 0;
+    vec4   rect{0.f};                // gBubbleRect[0]
+    std::vector<vec2> verts;
+
+    static void quad(std::vector<vec2> &v,vec2 a,vec2 b){
+        v.insert(v.end(),{a,vec2(b.x,a.y),b, a,b,vec2(a.x,b.y)});
+    }
+    //  true if some tile can skip the marcher (list then current)
+    bool update(int rw,int rh){
+        if(!enabled || gBubbleCount>1) return false;   // panels: one draw for all
+        float Rn = gWarp.sagDepth_nm*1e-9f;
+        mat4  V  = gCam.view();
+        if(V!=view || fov!=gCam.fov || R!=Rn || w!=rw || h!=rh || rect!=gBubbleRect[0]){
+            view = V; fov = gCam.fov; R = Rn; w = rw; h = rh; rect = gBubbleRect[0];
+            rebuild();
+        }
+        return live < total;
+    }
+    void rebuild(){
+        int   nx = (w+kTileSize-1)/kTileSize, ny = (h+kTileSize-1)/kTileSize;
+        float Rs = kSupport*R, dist = length(gCam.pos);
+        total = nx*ny;
+        if(dist <= Rs){ live = total; return; }
+        mat4  P   = gCam.proj(float(gW)/float(gH));
+        mat3  rot = mat3(inverse(view));
+        vec2  ext = vec2(rect.z-rect.x,rect.w-rect.y);
+        vec2  ps  = vec2(1.0f/P[0][0]*ext.x/ext.y,1.0f/P[1][1]);   // kFrag's projScale
+        vec3  c   = -gCam.pos/dist;
+        float sphere = std::asin(Rs/dist);
+        auto  ray = [&](vec2 ndc){ return normalize(rot*vec3(ndc*ps,-1.0f)); };
+        std::vector<vec2> dead;
+        verts.clear(); live = 0;
+        for(int ty=0;ty<ny;++ty) for(int tx=0;tx<nx;++tx){
+            vec2 a = vec2(float(tx*kTileSize)/float(w),float(ty*kTileSize)/float(h))*2.0f-1.0f;
+            vec2 b = vec2(float(min((tx+1)*kTileSize,w))/float(w),
+                          float(min((ty+1)*kTileSize,h))/float(h))*2.0f-1.0f;
+            vec3  m    = ray((a+b)*0.5f);
+            float half = 0.f;
+            for(vec2 k : {a,b,vec2(a.x,b.y),vec2(b.x,a.y)})
+                half = max(half,std::acos(glm::clamp(dot(m,ray(k)),-1.0f,1.0f)));
+            float off = std::acos(glm::clamp(dot(m,c),-1.0f,1.0f));
+            if(off <= sphere + half + 1e-3f){ quad(verts,a,b); ++live; }
+            else quad(dead,a,b);
+        }
+        verts.insert(verts.end(),dead.begin(),dead.end());
+        if(!vao){
+            glGenVertexArrays(1,&vao); glGenBuffers(1,&vbo);
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER,vbo);
+            glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,0,(void*)0);
+            glEnableVertexAttribArray(0);
+        }
+        gpuBufferData(kPoolFixed,GL_ARRAY_BUFFER,vbo,verts.size()*sizeof(vec2),verts.data(),GL_DYNAMIC_DRAW);
+    }
+    void drawLive() const { glBindVertexArray(vao); glDrawArrays(GL_TRIANGLES,0,6*live); }
+    void drawDead() const { glBindVertexArray(vao); glDrawArrays(GL_TRIANGLES,6*live,6*(total-live)); }
+    float coverage() const { return total && enabled ? float(live)/float(total) : 1.0f; }
+} gTiles;
+
+//---------------------------------------------------------------
+//  INSTRUMENTATION  (CPU frame phases + GPU draw timer)
+//---------------------------------------------------------------
+//  Every phase keeps the last kStatWindow samples plus an incremental
+//  log₂ histogram over them (bin i starts at kStatBinLo·2^(i/2) ms;
+//  bin 0 also takes everything below).  Summaries are refreshed once
+//  per rendered frame into gFrameStats, a plain struct JS reads through
+//  views it builds once over the pointer from getFrameStats():
+//      Uint32Array  words 0‑2   frames, gpuTimer, shaderState
+//      Float32Array word  3     renderScale
+//      Float32Array words 4…    PhaseStats[kPhaseCount]
+//      Uint32Array  then        GpuUsage (bytes; see GPU RESOURCES)
+//  so polling the numbers allocates nothing on either side.
+enum Phase : int { kPhasePoll, kPhaseUBO, kPhaseDraw, kPhaseSwap,
+                   kPhaseFrame, kPhaseGPU, kPhaseCount };
+constexpr int   kStatWindow = 128;
+constexpr int   kStatBins   = 24;
+constexpr float kStatBinLo  = 1.0f/64.0f;     // ms; top bin opens at 64 ms
+
+struct PhaseStats {                  // ms over the rolling window
+    float last, mean, p50, p95, max;
+    float hist[kStatBins];           // sample counts
+};
+struct GpuUsage {
+    uint32_t total, peak, budget;
+    uint32_t evictions;              // caches dropped or narrowed so far
+    uint32_t pool[kPoolCount];       // GpuPool order
+};
+struct FrameStats {
+    uint32_t   frames;               // rendered frames since start
+    uint32_t   gpuTimer;             // 1 → kPhaseGPU is measured on the GPU
+    uint32_t   shaderState;          // ShaderState of the requested variant
+    float      renderScale;          // ResGovernor::scale
+    PhaseStats phase[kPhaseCount];
+    GpuUsage   gpu;
+};
+static FrameStats gFrameStats = {};
+
+struct RollingHist {
+    float s[kStatWindow] = {};
+    int   head = 0, count = 0;
+    float sum  = 0.f;
+    float hist[kStatBins] = {};
+
+    static int bin(float ms){
+        if(ms <= kStatBinLo) return 0;
+        return min(kStatBins-1,int(2.0f*std::log2(ms/kStatBinLo)));
+    }
+    void push(float ms){
+        if(count==kStatWindow){ sum -= s[head]; hist[bin(s[head])] -= 1.f; }
+        else ++count;
+        s[head] = ms; sum += ms; hist[bin(ms)] += 1.f;
+        head = (head+1)%kStatWindow;
+    }
+    void summarize(PhaseStats &o) const {
+        if(!count) return;
+        float tmp[kStatWindow];
+        std::copy(s,s+count,tmp);
+        int i50 = count/2, i95 = min(count-1,(count*95)/100);
+        std::nth_element(tmp,tmp+i50,tmp+count);      o.p50 = tmp[i50];
+        std::nth_element(tmp+i50,tmp+i95,tmp+count);  o.p95 = tmp[i95];
+        o.max  = *std::max_element(tmp+i95,tmp+count);
+        o.last = s[(head+kStatWindow-1)%kStatWindow];
+        o.mean = sum/float(count);
+        std::copy(hist,hist+kStatBins,o.hist);
+    }
+};
+static RollingHist gPhaseHist[kPhaseCount];
+
+static inline float msSince(Clock::time_point t0){
+    return std::chrono::duration<float,std::milli>(Clock::now()-t0).count();
+}
+
+//  GPU time of the marcher draw via EXT_disjoint_timer_query(_webgl2).
+//  Results are read kGpuQueries frames late at the earliest and never
+//  waited on; a frame is simply not timed if every query is in flight.
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT  0x88BF
+#define GL_GPU_DISJOINT_EXT  0x8FBB
+#endif
+constexpr int kGpuQueries = 4;
+struct GpuTimer {
+    GLuint q[kGpuQueries] = {};
+    int    head = 0, pending = 0;
+    bool   live = false, open = false;
+    float  lastMs = -1.f;                // newest result, < 0: none yet (ResGovernor)
+
+    void init(){
+        live = hasGLExtension("EXT_disjoint_timer_query_webgl2") ||
+               hasGLExtension("GL_EXT_disjoint_timer_query");
+        if(live) glGenQueries(kGpuQueries,q);
+    }
+    void begin(){
+        open = live && pending < kGpuQueries;
+        if(open) glBeginQuery(GL_TIME_ELAPSED_EXT,q[head]);
+    }
+    void end(){
+        if(!open) return;
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+        head = (head+1)%kGpuQueries; ++pending; open = false;
+    }
+    void poll(){
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT,&disjoint);
+        while(pending){
+            GLuint oldest = q[(head+kGpuQueries-pending)%kGpuQueries], ready = 0, ns = 0;
+            glGetQueryObjectuiv(oldest,GL_QUERY_RESULT_AVAILABLE,&ready);
+            if(!ready) break;
+            glGetQueryObjectuiv(oldest,GL_QUERY_RESULT,&ns);
+            if(!disjoint){ lastMs = float(ns)*1e-6f; gPhaseHist[kPhaseGPU].push(lastMs); }
+            --pending;
+        }
+    }
+} gGpuTimer;
+
+void publishFrameStats(){
+    ++gFrameStats.frames;
+    gFrameStats.gpuTimer    = gGpuTimer.live;
+    gFrameStats.renderScale = gRes.scale;
+    for(int i=0;i<kPhaseCount;++i) gPhaseHist[i].summarize(gFrameStats.phase[i]);
+    GpuUsage &g = gFrameStats.gpu;
+    g.total = uint32_t(gGpu.total); g.peak = uint32_t(gGpu.peak);
+    g.budget = uint32_t(std::min(gGpu.budget,size_t(UINT32_MAX)));
+    g.evictions = gGpu.evictions;
+    for(int i=0;i<kPoolCount;++i) g.pool[i] = uint32_t(gGpu.pool[i]);
+}
+
+//---------------------------------------------------------------
+//  PHYSICS CHANNELS  (MRT float output + on‑GPU reductions)
+//---------------------------------------------------------------
+//  With setPhysics(1) the marcher is built with WARP_PHYSICS.  Next to
+//  the colour it writes an RGBA16F attachment holding:
+//    R  peak |β| met by the ray
+//    G  redshift z = ν_far/ν_eye - 1 = |p| - 1 at the far end (> 0: redder)
+//    B  coordinate time ∫(E - β·p)dλ spent inside the support, in R/c
+//    A  the step count
+//  Such frames render colour and channels into gPhysics.fbo and blit
+//  the colour, so the direct path and temporal accumulation sit out.
+//  kFragReduce then folds 4×4 blocks per pass into RGBA32F sum,
+//  max and two 4‑bin step histograms (bin = steps·8/(kMaxSteps+1))
+//  until one texel is left: five passes at 800×600.  generateMipmap
+//  would only give the mean, so the chain is explicit.  The last texel
+//  of each of the four targets is read through a fenced PBO, as in
+//  ASYNC CAPTURE.  JS therefore gets 80 bytes of PhysicsStats 1–3
+//  frames late instead of a full readback.  The channels themselves
+//  can still be streamed with setCapture(capturePhysics).
+//  All of it needs EXT_color_buffer_float; without it the state stays
+//  kPhysicsUnsupported.  kPhysicsNoMemory means the targets did not fit
+//  the GPU budget; setPhysics(1) tries again.  Turning physics off frees
+//  the targets.
+//      Uint32Array  words 0‑2   state, frame, pixels
+//      Float32Array words 4…    mean[4], max[4], hist[kPhysBins]
+enum PhysicsState : uint32_t { kPhysicsOff = 0, kPhysicsOn = 1, kPhysicsUnsupported = 2,
+                               kPhysicsNoMemory = 3 };
+constexpr int kPhysSlots = 3;             // stat readbacks in flight
+constexpr int kPhysBins  = 8;             // step histogram bins
+static_assert(kPhysBins==8,"kFragReduce writes the bins as two vec4");
+
+struct PhysicsStats {
+    uint32_t state;                       // PhysicsState
+    uint32_t frame;                       // render frame the numbers belong to
+    uint32_t pixels;                      // rw·rh they were reduced over
+    uint32_t pad;
+    float    mean[4];                     // peak |β|, z, ∫dt /R, steps
+    float    max[4];                      // max[1]: the most redshifted ray
+    float    hist[kPhysBins];             // share of pixels per step bin
+};
+
+struct Physics {
+    bool     on = false;
+    GLuint   color = 0, tex = 0, fbo = 0; // RGBA8 colour + channels; gTW × gTH, drawn rw × rh
+    GLuint   red[2][4] = {}, redFBO[2] = {};   // sum, max, hist lo, hist hi
+    GLuint   first = 0, rest = 0;         // kFragReduce with / without PHYS_FIRST
+    GLint    locFirstSize = -1, locRestSize = -1;
+    GLuint   pbo[kPhysSlots]   = {};
+    GLsync   fence[kPhysSlots] = {};
+    uint32_t tag[kPhysSlots] = {}, px[kPhysSlots] = {};
+    int      head = 0, pending = 0;
+    PhysicsStats stats = {};
+
+    bool inFlight() const { return pending>0; }
+
+    //  off releases the targets; the next active() rebuilds them
+    void enable(bool want){
+        on = want && stats.state!=kPhysicsUnsupported;
+        if(stats.state!=kPhysicsUnsupported) stats.state = on ? kPhysicsOn : kPhysicsOff;
+        if(!on) release();
+    }
+    //  targets are made by the first frame that wants them
+    bool active(){
+        if(on && !tex){
+            PhysicsState st = init(gTW,gTH);
+            if(st!=kPhysicsOn){ on = false; stats.state = st; }
+        }
+        return on;
+    }
+    static void sampling(){
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+    }
+    static size_t bytes(int W,int H){
+        return size_t(W)*size_t(H)*(4+8) + 8*size_t((W+3)/4)*size_t((H+3)/4)*16;
+    }
+    PhysicsState init(int W,int H){
+        if(!glExtension("EXT_color_buffer_float")) return kPhysicsUnsupported;
+        if(!gGpu.reserve(kPoolPhysics,bytes(W,H))) return kPhysicsNoMemory;
+        static const GLenum att[4] = {GL_COLOR_ATTACHMENT0,GL_COLOR_ATTACHMENT1,
+                                      GL_COLOR_ATTACHMENT2,GL_COLOR_ATTACHMENT3};
+        color = gpuTexture(kPoolPhysics,GL_RGBA8,W,H);   sampling();
+        tex   = gpuTexture(kPoolPhysics,GL_RGBA16F,W,H); sampling();
+        glGenFramebuffers(1,&fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER,fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,color,0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT1,GL_TEXTURE_2D,tex,0);
+        glDrawBuffers(2,att);
+        glGenFramebuffers(2,redFBO);
+        for(int s=0;s<2;++s){
+            glBindFramebuffer(GL_FRAMEBUFFER,redFBO[s]);
+            for(int i=0;i<4;++i){
+                red[s][i] = gpuTexture(kPoolPhysics,GL_RGBA32F,(W+3)/4,(H+3)/4); sampling();
+                glFramebufferTexture2D(GL_FRAMEBUFFER,att[i],GL_TEXTURE_2D,red[s][i],0);
+            }
+            glDrawBuffers(4,att);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+        if(first) return kPhysicsOn;          // programs and PBOs outlive a release
+        first = createProgram({"#version 300 es\n#define PHYS_FIRST\n",kFragConstants,kFragReduce});
+        rest  = createProgram({"#version 300 es\n",kFragConstants,kFragReduce});
+        locFirstSize = glGetUniformLocation(first,"uSize");
+        locRestSize  = glGetUniformLocation(rest,"uSize");
+        glUseProgram(first);
+        glUniform1i(glGetUniformLocation(first,"uIn0"),2);
+        glUseProgram(rest);
+        for(int i=0;i<4;++i){
+            char name[] = "uIn0"; name[3] = char('0'+i);
+            glUniform1i(glGetUniformLocation(rest,name),2+i);
+        }
+        for(GLuint &b : pbo)
+            b = gpuBufferData(kPoolPhysics,GL_PIXEL_PACK_BUFFER,0,16*sizeof(float),nullptr,GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+        return kPhysicsOn;
+    }
+    void release(){
+        gpuFree(color,false); gpuFree(tex,false);
+        for(auto &set : red) for(GLuint &t : set) gpuFree(t,false);
+        glDeleteFramebuffers(1,&fbo); glDeleteFramebuffers(2,redFBO);
+        fbo = redFBO[0] = redFBO[1] = 0;
+    }
+
+    //  after the channels of an rw × rh frame are drawn
+    void reduce(int rw,int rh){
+        int nx = rw, ny = rh, dst = 0;
+        glBindVertexArray(gVAO);
+        for(bool firstPass = true;;firstPass = false){
+            int ox = (nx+3)/4, oy = (ny+3)/4;
+            glBindFramebuffer(GL_FRAMEBUFFER,redFBO[dst]);
+            glViewport(0,0,ox,oy);
+            glUseProgram(firstPass ? first : rest);
+            glUniform2i(firstPass ? locFirstSize : locRestSize,nx,ny);
+            for(int i=0;i<(firstPass ? 1 : 4);++i){
+                glActiveTexture(GL_TEXTURE2+i);
+                glBindTexture(GL_TEXTURE_2D,firstPass ? tex : red[dst^1][i]);
+            }
+            glActiveTexture(GL_TEXTURE0);
+            glDrawArrays(GL_TRIANGLES,0,6);
+            nx = ox; ny = oy;
+            if(nx==1 && ny==1) break;
+            dst ^= 1;
+        }
+        if(pending==kPhysSlots) return;        // JS already has fresher ones queued
+        glBindFramebuffer(GL_READ_FRAMEBUFFER,redFBO[dst]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,pbo[head]);
+        for(int i=0;i<4;++i){
+            glReadBuffer(GL_COLOR_ATTACHMENT0+i);
+            glReadPixels(0,0,1,1,GL_RGBA,GL_FLOAT,reinterpret_cast<void*>(uintptr_t(16*i)));
+        }
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+        fence[head] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+        tag[head] = gFrameStats.frames; px[head] = uint32_t(rw)*uint32_t(rh);
+        head = (head+1)%kPhysSlots; ++pending;
+    }
+    //  finished reductions → stats, oldest first; never waits
+    void poll(){
+        while(pending){
+            int i = (head+kPhysSlots-pending)%kPhysSlots;
+            if(glClientWaitSync(fence[i],0,0)==GL_TIMEOUT_EXPIRED) break;
+            glDeleteSync(fence[i]); fence[i] = nullptr;
+            float v[16];
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,pbo[i]);
+            glGetBufferSubData(GL_PIXEL_PACK_BUFFER,0,GLsizeiptr(sizeof(v)),v);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+            float inv = 1.0f/float(max(px[i],1u));
+            for(int c=0;c<4;++c){ stats.mean[c] = v[c]*inv; stats.max[c] = v[4+c]; }
+            for(int b=0;b<kPhysBins;++b) stats.hist[b] = v[8+b]*inv;
+            stats.frame = tag[i]; stats.pixels = px[i];
+            --pending;
+        }
+    }
+} gPhysics;
+
+//---------------------------------------------------------------
+//  FLOW TRACERS  (transform‑feedback particles advected by β)
+//---------------------------------------------------------------
+//  WebGL2 has no compute stage, so the particle update is a vertex
+//  pass under GL_RASTERIZER_DISCARD.  kVertTracerStep reads one state
+//  buffer and writes the other through transform feedback, and the two
+//  swap every frame.  The draw pass then splats the fresh buffer as
+//  additive points over the finished image.  Particle data is
+//  initialised once on the GPU and never read back, so 10⁶ tracers
+//  cost two buffer passes and no CPU time.  They follow bubble 0's
+//  Eulerian flow dx/dt = β in coordinate time, timeScale R/c per wall
+//  second.  A tracer respawns inside s < 2.5 when it leaves the
+//  support or reaches its lifetime.  Points are projected along
+//  straight eye rays into panel 0: they show the flow itself, not its
+//  lensed image.  While tracers are on, the loop keeps drawing in
+//  on‑demand mode too.  The count is clamped to what the GPU budget
+//  leaves (FrameStats::gpu shows the bytes granted).
+constexpr int kTracerMax = 1<<20;           // 2 × 16 MB of state at most
+
+struct Tracers {
+    int      want = 0, asked = 0, count = 0;   // requested / last allocated for / allocated
+    float    timeScale = 1.f, pointSize = 2.f;
+    GLuint   vbo[2] = {}, vao[2] = {};
+    GLuint   step = 0, draw = 0;
+    GLint    locDt = -1, locSeed = -1, locEyeRot = -1, locEyeR = -1,
+             locProjScale = -1, locPointSize = -1, locGain = -1;
+    int      cur = 0;                       // buffer holding the newest state
+    uint32_t seed = 0;
+    Clock::time_point last{};
+
+    static GLuint program(const char *vert,const char *frag,const char *feedback){
+        GLuint v = compileShader(GL_VERTEX_SHADER,{"#version 300 es\n",kFragConstants,kWarpBlock,
+                                                   kShiftKernel,vert});
+        GLuint f = compileShader(GL_FRAGMENT_SHADER,{frag});
+        GLuint p = glCreateProgram(); glAttachShader(p,v); glAttachShader(p,f);
+        if(feedback) glTransformFeedbackVaryings(p,1,&feedback,GL_INTERLEAVED_ATTRIBS);
+        glLinkProgram(p); glDeleteShader(v); glDeleteShader(f);
+        glUniformBlockBinding(p,glGetUniformBlockIndex(p,"WarpUniforms"),0);
+        return p;
+    }
+    void init(){
+        step = program(kVertTracerStep,kFragDiscard,"vState");
+        draw = program(kVertTracerDraw,kFragTracer,nullptr);
+        locDt        = glGetUniformLocation(step,"uDt");
+        locSeed      = glGetUniformLocation(step,"uSeed");
+        locEyeRot    = glGetUniformLocation(draw,"uEyeRot");
+        locEyeR      = glGetUniformLocation(draw,"uEyeR");
+        locProjScale = glGetUniformLocation(draw,"uProjScale");
+        locPointSize = glGetUniformLocation(draw,"uPointSize");
+        locGain      = glGetUniformLocation(draw,"uGain");
+        glGenBuffers(2,vbo); glGenVertexArrays(2,vao);
+        for(int i=0;i<2;++i){
+            glBindVertexArray(vao[i]);
+            glBindBuffer(GL_ARRAY_BUFFER,vbo[i]);
+            glVertexAttribPointer(0,4,GL_FLOAT,GL_FALSE,0,(void*)0);
+            glEnableVertexAttribArray(0);
+        }
+        glBindVertexArray(0);
+    }
+    //  (re)allocates both buffers, clamped to what the GPU budget has
+    //  room for (0 frees them); age = ∞ makes the first step spawn all
+    void allocate(int n){
+        if(!step) init();
+        asked = n;
+        size_t per = 2*sizeof(vec4), held = gGpu.pool[kPoolTracers];
+        if(size_t(n)*per > held && !gGpu.reserve(kPoolTracers,size_t(n)*per-held)){
+            size_t others = gGpu.total-held;
+            n = int(std::min(size_t(n),gGpu.budget > others ? (gGpu.budget-others)/per : size_t(0)));
+        }
+        std::vector<vec4> seedState(size_t(n),vec4(0.f,0.f,0.f,3.0e38f));
+        for(GLuint b : vbo)
+            gpuBufferData(kPoolTracers,GL_ARRAY_BUFFER,b,size_t(n)*sizeof(vec4),seedState.data(),GL_DYNAMIC_COPY);
+        glBindBuffer(GL_ARRAY_BUFFER,0);
+        count = n; cur = 0; last = Clock::time_point{};
+    }
+
+    //  advance and draw onto the canvas, after the frame's image is done
+    void frame(){
+        if(want!=asked) allocate(want);
+        if(!count) return;
+        Clock::time_point now = Clock::now();
+        float wall = last==Clock::time_point{} ? 0.f
+                   : std::min(std::chrono::duration<float>(now-last).count(),0.1f);
+        last = now;
+
+        glUseProgram(step);
+        glUniform1f(locDt,wall*timeScale);
+        glUniform1ui(locSeed,++seed);
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(vao[cur]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER,0,vbo[cur^1]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS,0,count);
+        glEndTransformFeedback();
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER,0,0);
+        glDisable(GL_RASTERIZER_DISCARD);
+        cur ^= 1;
+
+        vec4  r  = (gBubbleRect[0]*0.5f + 0.5f)*vec4(gW,gH,gW,gH);
+        vec4  e  = gBubbleRect[0];
+        mat4  P  = gCam.proj(float(gW)/float(gH));
+        vec3  eye = gCam.eyeR(gWarp.sagDepth_nm);
+        mat3  rot = mat3(inverse(gCam.view()));
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+        glViewport(GLint(r.x),GLint(r.y),GLsizei(r.z-r.x),GLsizei(r.w-r.y));
+        glUseProgram(draw);
+        glUniformMatrix3fv(locEyeRot,1,GL_FALSE,value_ptr(rot));
+        glUniform3f(locEyeR,eye.x,eye.y,eye.z);
+        glUniform2f(locProjScale,(e.z-e.x)/(e.w-e.y)/P[0][0],1.0f/P[1][1]);
+        glUniform1f(locPointSize,pointSize);
+        glUniform1f(locGain,std::min(0.6f,2e4f/float(count)));   // keep 10⁶ from saturating
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE,GL_ONE);
+        glBindVertexArray(vao[cur]);
+        glDrawArrays(GL_POINTS,0,count);
+        glDisable(GL_BLEND);
+        glViewport(0,0,gW,gH);
+    }
+} gTracers;
+
+//---------------------------------------------------------------
+//  ASYNC CAPTURE  (PBO + fence readback, no pipeline stall)
+//---------------------------------------------------------------
+//  While a capture runs, every rendered frame is read into the next of
+//  kCaptureSlots pixel‑pack buffers.  With a PBO bound, glReadPixels
+//  only queues a GPU copy, which is then fenced.  Later frames poll the
+//  fences without waiting.  A signalled one is drained with
+//  glGetBufferSubData into slot n % kCaptureHostSlots of a preallocated
+//  heap region that JS views directly.  A frame therefore reaches JS
+//  1–3 frames after it was drawn and nothing blocks.  If every PBO is
+//  still in flight that frame is skipped and counted in `dropped`.
+//  JS keeps its own read index against `head`, the parameter ring in
+//  reverse.  Delivered frame n sits at byte (n % kCaptureHostSlots)·bytes
+//  of captureSlots(), and its render frame number is in
+//  frame[n % kCaptureHostSlots].  Views must be re‑fetched when `layout`
+//  moves (new size or source) or if the heap grows.
+//  kCaptureRGBA8 reads the canvas.  kCapturePhysics reads the rw × rh
+//  float channels of PHYSICS CHANNELS as RGBA32F (16 bytes per pixel),
+//  and only frames that drew them.  The PBOs are charged to the GPU
+//  budget: a capture that does not fit stops (source reads captureOff),
+//  and a stopped one frees them once its reads have drained.
+constexpr int kCaptureSlots     = 3;      // PBOs in flight = latency bound
+constexpr int kCaptureHostSlots = 4;      // delivered frames JS may lag by
+
+enum CaptureSource : int { kCaptureOff = 0, kCaptureRGBA8 = 1, kCapturePhysics = 2 };
+
+struct CaptureHeader {                    // JS: Uint32Array view
+    std::atomic<uint32_t> head{0};        // frames delivered so far
+    uint32_t layout  = 0;                 // bumped when the slot region is rebuilt
+    uint32_t width   = 0, height = 0, bytes = 0;
+    uint32_t source  = kCaptureOff;
+    uint32_t dropped = 0;                 // frames skipped, every PBO busy
+    uint32_t frame[kCaptureHostSlots] = {};
+};
+static_assert(sizeof(CaptureHeader)==(7+kCaptureHostSlots)*sizeof(uint32_t),
+              "captureHeader() is read as a flat Uint32Array");
+
+struct AsyncCapture {
+    CaptureHeader        hdr;
+    std::vector<uint8_t> host;            // kCaptureHostSlots × hdr.bytes
+    GLuint   pbo[kCaptureSlots]   = {};
+    GLsync   fence[kCaptureSlots] = {};
+    uint32_t tag[kCaptureSlots]   = {};   // render frame of each read
+    int      head = 0, pending = 0;
+    int      source = kCaptureOff;
+    bool     sized  = false;              // PBOs hold hdr.bytes each
+
+    bool inFlight() const { return pending>0; }
+
+    void start(int src){ source = src; }
+    void stop(){ source = kCaptureOff; }  // reads in flight still drain
+
+    //  PBOs and host slots follow the canvas; a change drops what is
+    //  queued.  false: the PBOs do not fit the GPU budget, capture stops
+    bool shape(int w,int h){
+        uint32_t bytes = uint32_t(w)*uint32_t(h)*(source==kCapturePhysics ? 16u : 4u);
+        if(sized && bytes==hdr.bytes && uint32_t(w)==hdr.width && uint32_t(source)==hdr.source) return true;
+        size_t held = gGpu.pool[kPoolCapture], need = size_t(bytes)*kCaptureSlots;
+        if(need > held && !gGpu.reserve(kPoolCapture,need-held)){
+            source = kCaptureOff; hdr.source = kCaptureOff;
+            return false;
+        }
+        if(!pbo[0]) glGenBuffers(kCaptureSlots,pbo);
+        for(GLsync &f : fence) if(f){ glDeleteSync(f); f = nullptr; }
+        head = 0; pending = 0;
+        for(GLuint b : pbo) gpuBufferData(kPoolCapture,GL_PIXEL_PACK_BUFFER,b,bytes,nullptr,GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+        host.assign(size_t(bytes)*kCaptureHostSlots,0);
+        hdr.width = uint32_t(w); hdr.height = uint32_t(h); hdr.bytes = bytes;
+        hdr.source = uint32_t(source);
+        ++hdr.layout; sized = true;
+        return true;
+    }
+    //  once the frame is in the default framebuffer, before the swap
+    void record(int rw,int rh,bool physFrame){
+        bool phys = source==kCapturePhysics;
+        if(source==kCaptureOff || (phys && !physFrame)) return;
+        if(!shape(phys ? rw : gW,phys ? rh : gH)) return;
+        if(pending==kCaptureSlots){ ++hdr.dropped; return; }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER,phys ? gPhysics.fbo : 0);
+        if(phys) glReadBuffer(GL_COLOR_ATTACHMENT1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,pbo[head]);
+        glReadPixels(0,0,GLsizei(hdr.width),GLsizei(hdr.height),GL_RGBA,
+                     phys ? GL_FLOAT : GL_UNSIGNED_BYTE,nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+        if(phys) glReadBuffer(GL_COLOR_ATTACHMENT0);
+        fence[head] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+        tag[head]   = gFrameStats.frames;
+        head = (head+1)%kCaptureSlots; ++pending;
+    }
+    //  hands every finished read to JS, oldest first; never waits
+    void poll(){
+        while(pending){
+            int i = (head+kCaptureSlots-pending)%kCaptureSlots;
+            if(glClientWaitSync(fence[i],0,0)==GL_TIMEOUT_EXPIRED) break;
+            glDeleteSync(fence[i]); fence[i] = nullptr;
+            uint32_t n = hdr.head.load(std::memory_order_relaxed);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,pbo[i]);
+            glGetBufferSubData(GL_PIXEL_PACK_BUFFER,0,GLsizeiptr(hdr.bytes),
+                               &host[size_t(n%kCaptureHostSlots)*hdr.bytes]);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+            hdr.frame[n%kCaptureHostSlots] = tag[i];
+            hdr.head.store(n+1,std::memory_order_release);
+            --pending;
+        }
+        if(source==kCaptureOff && !pending && sized){   // stopped and drained: free the PBOs
+            for(GLuint b : pbo) gpuBufferData(kPoolCapture,GL_PIXEL_PACK_BUFFER,b,0,nullptr,GL_STREAM_READ);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+            sized = false;                    // host slots stay readable
+        }
+    }
+} gCapture;
+
+#ifdef __EMSCRIPTEN__                       // typed‑array views for embind
+static emscripten::val captureHeader(){
+    return emscripten::val(emscripten::typed_memory_view(
+        sizeof(CaptureHeader)/sizeof(uint32_t),reinterpret_cast<uint32_t*>(&gCapture.hdr)));
+}
+static emscripten::val captureSlots(){
+    return emscripten::val(emscripten::typed_memory_view(gCapture.host.size(),gCapture.host.data()));
+}
+#endif
+
+//---------------------------------------------------------------
+//  SHARED‑MEMORY PARAMETER RING  (zero‑copy JS → engine updates)
+//---------------------------------------------------------------
+//  JS gets Float32Array / Uint32Array views straight onto this struct
+//  (warpRingSlots / warpRingHead) and, per update, writes 7 floats into
+//  slot[head % kWarpRingSize] and then increments head.  frame() only
+//  looks at the newest entry, so a timeline scrub that publishes
+//  hundreds of updates per frame costs the engine one copy.  In
+//  on‑demand mode JS calls requestRedraw() once after a burst.  With
+//  -pthread the heap is a SharedArrayBuffer and JS bumps head with
+//  Atomics.add, which is how the worker build receives parameters.
+//  Views must be re‑fetched if the WASM memory ever grows.
+constexpr int kWarpRingSize = 8;
+constexpr int kWarpFloats   = int(sizeof(WarpUniforms)/sizeof(float));
+static_assert(sizeof(WarpUniforms)==7*sizeof(float),"WarpUniforms must stay tightly packed");
+
+struct WarpUniformRing {
+    std::atomic<uint32_t> head{0};        // entries published by JS
+    uint32_t              pad[3];
+    WarpUniforms          slot[kWarpRingSize];
+};
+static WarpUniformRing gWarpRing;
+static uint32_t        gWarpRingSeen = 0;
+
+void requestRedraw();
+
+//  The field shape is (β₀ = dutyCycle·g_y, R) per bubble.  The caches
+//  keyed on gShapeGen (LUT rows, temporal history) are only dropped
+//  once one of the two drifts more than kShapeQuantum from the value
+//  they were last built with; that is below an RG16F ulp, so a slow
+//  ramp re‑bakes every few dozen frames instead of every frame.  The
+//  UBO always carries the exact values.
+constexpr float kShapeQuantum = 1.f/2048.f;
+static vec2 gShapeKey[WARP_MAX_BUBBLES];    // (β₀, sag) at the last bump
+
+static vec2 shapeOf(const WarpUniforms &w){ return vec2(w.dutyCycle*w.g_y,w.sagDepth_nm); }
+static bool shapeMoved(vec2 a,vec2 b){
+    auto moved = [](float x,float y){
+        return std::fabs(x-y) > kShapeQuantum*std::max(std::fabs(x),std::fabs(y));
+    };
+    return moved(a.x,b.x) || moved(a.y,b.y);
+}
+//  every bump re‑bakes all rows, so every bubble is re‑keyed
+void bumpShape(){
+    ++gShapeGen;
+    for(int i=0;i<WARP_MAX_BUBBLES;++i) gShapeKey[i] = shapeOf(gBubbles[i]);
+}
+
+//  single entry point for new parameters of bubble i (bridge, ring or
+//  timeline)
+void commitBubble(int i,const WarpUniforms &w){
+    WarpUniforms &b = gBubbles[i];
+    if(std::memcmp(&w,&b,sizeof(w))==0) return;         // no‑op update
+    b = w; ++gWarpGen;
+    if(i==0) gBatchShape.store(packBatchShape(w.dutyCycle*w.g_y,w.sagDepth_nm),std::memory_order_relaxed);
+    if(shapeMoved(shapeOf(w),gShapeKey[i])) bumpShape();
+    requestRedraw();
+}
+void commitWarp(const WarpUniforms &w){ commitBubble(0,w); }
+
+void pullWarpRing(){
+    uint32_t head = gWarpRing.head.load(std::memory_order_acquire);
+    if(head==gWarpRingSeen) return;
+    WarpUniforms w;
+    do {        // retry if JS lapped the slot we were copying
+        std::memcpy(&w,&gWarpRing.slot[(head-1)%kWarpRingSize],sizeof(w));
+        std::atomic_thread_fence(std::memory_order_acquire);   // the copy before the re‑check
+        uint32_t now = gWarpRing.head.load(std::memory_order_relaxed);
+        if(now-head < kWarpRingSize-1) break;
+        head = now;
+    } while(true);
+    gWarpRingSeen = head;
+    commitWarp(w);
+}
+
+//  C++‑side producer (single writer: the page thread); used by the
+//  worker build so embind calls never touch gWarp from the wrong thread
+void pushWarpRing(const WarpUniforms &w){
+    uint32_t h = gWarpRing.head.load(std::memory_order_relaxed);
+    gWarpRing.slot[h%kWarpRingSize] = w;
+    gWarpRing.head.store(h+1,std::memory_order_release);
+}
+
+#ifdef __EMSCRIPTEN__
+static emscripten::val warpRingSlots(){
+    return emscripten::val(emscripten::typed_memory_view(
+        size_t(kWarpRingSize*kWarpFloats),&gWarpRing.slot[0].dutyCycle));
+}
+static emscripten::val warpRingHead(){
+    return emscripten::val(emscripten::typed_memory_view(
+        size_t(1),reinterpret_cast<uint32_t*>(&gWarpRing.head)));
+}
+#endif
+
+//---------------------------------------------------------------
+//  PARAMETER TIMELINE  (keyframed WarpUniforms, evaluated in frame())
+//---------------------------------------------------------------
+//  JS uploads keyframes once (timelineKey) and starts the clock; every
+//  frame then evaluates each keyed (bubble, field) track at the
+//  timeline time and goes through commitBubble, so a Hover → cruise
+//  ramp costs no bridge traffic at all.  Fields without keys keep
+//  whatever JS last sent.  A key's ease shapes the segment that leaves
+//  it; before the first and after the last key the track holds.
+//  kEaseGeometric interpolates ratios, for fields that span decades
+//  (cavityQ, exoticMass_kg), and falls back to linear across a sign
+//  change or zero.  While the clock runs the loop never parks,
+//  including on holds.  Time is wall‑clock seconds × rate.
+enum WarpField : int { kFieldDuty = 0, kFieldGy, kFieldQ, kFieldSag,
+                       kFieldTs, kFieldPower, kFieldMass };
+static_assert(kFieldMass+1==kWarpFloats,"one WarpField per WarpUniforms float");
+enum Ease : int { kEaseStep = 0, kEaseLinear, kEaseSmooth, kEaseIn, kEaseOut, kEaseGeometric };
+
+struct Keyframe { double t; float v; int ease; };
+
+struct Timeline {
+    std::vector<Keyframe> track[WARP_MAX_BUBBLES][kWarpFloats];
+    bool   running = false, loop = false;
+    double from = 0.0, rate = 1.0, now = 0.0, end = 0.0;   // seconds
+    Clock::time_point wall0;
+
+    //  adds a key or replaces the one at the same time
+    void key(int b,int f,double t,float v,int ease){
+        auto &k = track[b][f];
+        auto it = std::lower_bound(k.begin(),k.end(),t,
+                                   [](const Keyframe &a,double x){ return a.t < x; });
+        if(it!=k.end() && it->t==t) *it = {t,v,ease};
+        else k.insert(it,{t,v,ease});
+        end = std::max(end,t);
+    }
+    //  b < 0 clears every bubble; values keep their last evaluation
+    void clear(int b){
+        for(int i=0;i<WARP_MAX_BUBBLES;++i)
+            if(b<0 || i==b) for(auto &k : track[i]) k.clear();
+        end = 0.0;
+        for(auto &bt : track) for(auto &k : bt) if(!k.empty()) end = std::max(end,k.back().t);
+        if(end==0.0) running = false;
+    }
+
+    static float ease(const Keyframe &a,const Keyframe &b,double t){
+        double u = (t-a.t)/(b.t-a.t);
+        switch(a.ease){
+        case kEaseStep:   return a.v;
+        case kEaseSmooth: u = u*u*(3.0-2.0*u); break;
+        case kEaseIn:     u = u*u; break;
+        case kEaseOut:    u = 1.0-(1.0-u)*(1.0-u); break;
+        case kEaseGeometric:
+            if(double(a.v)*double(b.v) > 0.0) return float(a.v*std::pow(double(b.v)/a.v,u));
+            break;
+        default: break;
+        }
+        return float(a.v + (double(b.v)-a.v)*u);
+    }
+    static float eval(const std::vector<Keyframe> &k,double t){
+        if(t<=k.front().t) return k.front().v;
+        if(t>=k.back().t)  return k.back().v;
+        auto b = std::upper_bound(k.begin(),k.end(),t,
+                                  [](double x,const Keyframe &a){ return x < a.t; });
+        return ease(*(b-1),*b,t);
+    }
+
+    //  sets every keyed field to its value at time t
+    void apply(double t){
+        now = t;
+        for(int b=0;b<WARP_MAX_BUBBLES;++b){
+            WarpUniforms w = gBubbles[b];
+            bool keyed = false;
+            for(int f=0;f<kWarpFloats;++f){
+                if(track[b][f].empty()) continue;
+                (&w.dutyCycle)[f] = eval(track[b][f],t); keyed = true;
+            }
+            if(keyed) commitBubble(b,w);
+        }
+    }
+    void play(double t0,double r,bool l){
+        from = t0; rate = r; loop = l; wall0 = Clock::now();
+        running = end > 0.0 && r != 0.0;
+        apply(t0);
+    }
+    void stop(){ running = false; }
+    void seek(double t){
+        if(running){ from = t; wall0 = Clock::now(); }
+        apply(t);
+    }
+    //  once per frame, before the frame decides whether to render
+    void tick(){
+        if(!running) return;
+        double t = from + rate*std::chrono::duration<double>(Clock::now()-wall0).count();
+        if(loop){
+            t = std::fmod(t,end); if(t<0.0) t += end;
+        } else if(rate>0.0 ? t>=end : t<=0.0){
+            t = glm::clamp(t,0.0,end); running = false;   // land on the end key
+        }
+        apply(t);
+    }
+} gTimeline;
+
+//---------------------------------------------------------------
+//  STILL RENDERING  (progressive supersampled reference, time‑sliced)
+//---------------------------------------------------------------
+//  The high‑sample still for report screenshots.  Outside the worker
+//  build referenceStill() blocks until the last tile is done, which
+//  freezes a single‑threaded page.  startStill() instead takes the RefScene snapshot of gWarp
+//  and gCam and leaves the tracing to frame().  Each frame spends at
+//  most budgetMs in refTrace() and then goes back to the live picture.
+//  Later edits move the live view but not the still.
+//  The samples come in passes.  Pass s puts one ray in every pixel at
+//  Halton (2,3) offset s; pass 0 sits at the centre, as in referenceStill.
+//  After the first pass a complete 1‑spp image exists, and every later
+//  pass refines it (box filter).  A pass walks the kRefTile tiles in
+//  order, and a slice can stop between any two rays, so it overruns
+//  the budget by one ray at most.  The slice time is not counted in the
+//  frame phases or by the resolution governor, so the live view keeps
+//  its scale while a still runs.  image is rewritten for every ray, so
+//  it can be shown while it refines.
+constexpr int   kStillMaxSpp   = 4096;    // passes per still
+constexpr float kStillBudgetMs = 6.f;     // default tracing per frame
+
+enum StillState : int { kStillIdle = 0, kStillRunning = 1, kStillDone = 2 };
+
+struct StillRender {
+    RefScene             scene{};
+    std::vector<vec3>    sum;              // per‑pixel sample sum
+    std::vector<uint8_t> image;            // RGBA8, bottom row first
+    int      state = kStillIdle;
+    int      spp = 0, nx = 0, ny = 0;
+    int      pass = 0, tile = 0, pixel = 0;   // next ray
+    uint32_t gen = 0;                      // startStill() JS generation
+    double   rays = 0.0;                   // traced so far
+    float    progress = 0.f;               // rays / (spp · pixels)
+    float    budgetMs = kStillBudgetMs, ms = 0.f;   // ms: tracing time so far
+    void   (*notify)(bool done) = nullptr; // after every slice (JS ↔ C++ BRIDGE)
+
+    void start(int w,int h,int samples,float budget){
+        w = max(w,1); h = max(h,1);
+        scene    = refScene(w,h);
+        spp      = glm::clamp(samples,1,kStillMaxSpp);
+        budgetMs = budget > 0.f ? budget : kStillBudgetMs;
+        sum.assign(size_t(w)*size_t(h),vec3(0.f));
+        image.assign(size_t(w)*size_t(h)*4,255);
+        nx = (w+kRefTile-1)/kRefTile; ny = (h+kRefTile-1)/kRefTile;
+        pass = tile = pixel = 0; rays = 0.0; progress = 0.f; ms = 0.f;
+        state = kStillRunning;
+    }
+    void cancel(){ if(state==kStillRunning) state = kStillIdle; }   // image stays
+
+    //  one frame's share; false when there is nothing to trace
+    bool slice(){
+        if(state!=kStillRunning) return false;
+        Clock::time_point t0 = Clock::now();
+        int  w = scene.w, h = scene.h;
+        vec2 o = pass ? vec2(halton(uint32_t(pass),2),halton(uint32_t(pass),3)) : vec2(0.5f);
+        do {
+            int tx = (tile%nx)*kRefTile, ty = (tile/nx)*kRefTile;
+            int tw = min(kRefTile,w-tx), th = min(kRefTile,h-ty);
+            int x  = tx + pixel%tw, y = ty + pixel/tw;
+            vec2 ndc = (vec2(float(x),float(y))+o)/vec2(float(w),float(h))*2.0f - 1.0f;
+            size_t i = size_t(y)*size_t(w)+size_t(x);
+            sum[i] += refTrace(scene,ndc);
+            vec3 c = sum[i]/float(pass+1);
+            for(int k=0;k<3;++k) image[4*i+size_t(k)] = uint8_t(glm::clamp(c[k],0.0f,1.0f)*255.0f+0.5f);
+            rays += 1.0;
+            if(++pixel < tw*th) continue;
+            pixel = 0;
+            if(++tile < nx*ny) continue;
+            tile = 0;
+            if(++pass==spp){ state = kStillDone; break; }
+            o = vec2(halton(uint32_t(pass),2),halton(uint32_t(pass),3));
+        } while(msSince(t0) < budgetMs);
+        ms += msSince(t0);
+        progress = state==kStillDone ? 1.f : float(rays/(double(spp)*double(sum.size())));
+        if(notify) notify(state==kStillDone);
+        return true;
+    }
+} gStill;
+
+//---------------------------------------------------------------
+//  RENDER SCHEDULING  (continuous vs. on‑demand)
+//---------------------------------------------------------------
+//  In on‑demand mode the browser main loop is paused as soon as a frame
+//  finds nothing owed, so a static bubble costs no rAF callbacks at all.
+//  Anything that changes the picture goes through requestRedraw(), which
+//  resumes the loop for at least one more frame.
+enum RenderMode : int { kRenderContinuous = 0, kRenderOnDemand = 1 };
+enum DebugView  : int { kDebugOff = 0, kDebugSteps = 1 };
+static int  gDebugView  = kDebugOff;
+static int  gRenderMode = kRenderContinuous;
+static bool gRedraw     = true;           // a frame is owed
+static std::atomic<bool> gLoopPaused{false};
+
+void requestRedraw(){
+    gRedraw = true;
+    if(gLoopPaused){
+        gLoopPaused = false;
+        gRes.restart();                     // the pause is not frame time
+        loopResume();
+    }
+}
+
+//  true if this frame() should render; otherwise parks the loop
+bool beginFrame(){
+    if(gRenderMode==kRenderContinuous || gRedraw){ gRedraw = false; return true; }
+    gLoopPaused = true;                    // publish before the last look …
+    if(gWarpRing.head.load()!=gWarpRingSeen){  // … so a racing push is never lost
+        gLoopPaused = false;
+        pullWarpRing(); gRedraw = false;
+        return true;
+    }
+    if(gCapture.inFlight() || gPhysics.inFlight() || gTimeline.running ||
+       gStill.state==kStillRunning){
+        gLoopPaused = false; return false;       // tick on: reads to drain, clock to run, still to trace
+    }
+    loopPause();
+    return false;
+}
+
+//  Bridge calls arrive on the page thread.  In the worker build they are
+//  proxied to the render thread; otherwise they simply run in place.
+#ifdef WARP_OFFSCREEN
+static pthread_t gRenderThread;
+static void runBoxed(void *p){
+    auto *f = static_cast<std::function<void()>*>(p);
+    (*f)(); delete f;
+}
+void onRenderThread(std::function<void()> f){
+    if(pthread_equal(pthread_self(),gRenderThread)){ f(); return; }
+    emscripten_proxy_async(emscripten_proxy_get_system_queue(),gRenderThread,
+                           runBoxed,new std::function<void()>(std::move(f)));
+}
+#else
+template<class F> void onRenderThread(F &&f){ f(); }
+#endif
+
+//  JS‑facing redraw request, safe from any thread
+void postRedraw(){ onRenderThread(requestRedraw); }
+
+//---------------------------------------------------------------
+//  CANVAS SIZE  (CSS box × capped DPR, bucketed render targets)
+//---------------------------------------------------------------
+//  The drawing buffer follows the canvas' CSS size times
+//  devicePixelRatio, capped at gDprCap: past 2× a 4K panel or a phone
+//  pays 2–4× the pixels for detail nobody sees in a soft field.  The
+//  offscreen targets (gSceneFBO, temporal history, physics channels)
+//  are sized gTW × gTH, the canvas rounded up to kCanvasBucket.  They
+//  are rebuilt only when the canvas outgrows them or its bucket falls
+//  to half their area, so dragging a window edge moves the viewport
+//  and the blit rectangle but reallocates once per bucket at most.
+//  Temporal and physics targets are just released; the next frame
+//  that wants them rebuilds them at the new size (ready(), active()).
+//  Captures follow the canvas size by themselves (ASYNC CAPTURE).  A
+//  canvas whose CSS size is taken from its width and height attributes
+//  (Emscripten's default shell) would grow with every fit.  The browser
+//  canvasSetSize() therefore pins such a canvas' CSS box at the size it
+//  had before the first resize.
+constexpr int kCanvasBucket = 128;         // target size step, pixels
+static float  gDprCap = 2.f;               // ≤ 0 → uncapped
+
+static int canvasBucket(int n){ return (n+kCanvasBucket-1)/kCanvasBucket*kCanvasBucket; }
+
+//  W × H drawing buffer; the targets move only across a bucket
+static void resizeCanvas(int W,int H){
+    static GLint maxTex = 0;
+    if(!maxTex) glGetIntegerv(GL_MAX_TEXTURE_SIZE,&maxTex);
+    W = glm::clamp(W,1,int(maxTex)); H = glm::clamp(H,1,int(maxTex));
+    if(W!=gW || H!=gH){
+        canvasSetSize(W,H);
+        gW = W; gH = H;
+    }
+    int  bw = min(canvasBucket(W),int(maxTex)), bh = min(canvasBucket(H),int(maxTex));
+    bool grow   = W>gTW || H>gTH;
+    bool shrink = 2*size_t(bw)*size_t(bh) <= size_t(gTW)*size_t(gTH);
+    if(gSceneFBO && !grow && !shrink) return;
+    gTW = bw; gTH = bh;
+    gpuFree(gSceneTex,false);
+    glDeleteFramebuffers(1,&gSceneFBO); gSceneFBO = 0;
+    initSceneTarget(gTW,gTH);
+    gTemporal.release();
+    gPhysics.release();
+}
+//  CSS size × min(devicePixelRatio, gDprCap) of the canvas now
+static void fitCanvas(){
+    double cw = 0, ch = 0;
+    if(!canvasCssSize(cw,ch)){ resizeCanvas(gW,gH); return; }   // no layout yet: keep the size
+    double dpr = canvasPixelRatio();
+    if(gDprCap > 0.f) dpr = std::min(dpr,double(gDprCap));
+    resizeCanvas(int(cw*dpr+0.5),int(ch*dpr+0.5));
+}
+
+//  a resized canvas loses its drawing buffer → resize and repaint it
+static void onResize(){
+    fitCanvas();
+    requestRedraw();
 }
 
 //---------------------------------------------------------------
@@ -174,46 +2893,998 @@ void syncUBO(){
 //---------------------------------------------------------------
 extern "C" EMSCRIPTEN_KEEPALIVE
 void updateWarpUniforms(float duty,float gy,float q,float sag,float ts,float pwr,float mass){
-    gWarp = {duty,gy,q,sag,ts,pwr,mass};
+#ifdef WARP_OFFSCREEN
+    pushWarpRing({duty,gy,q,sag,ts,pwr,mass});      // picked up by frame()
+    if(gLoopPaused.load()) postRedraw();
+#else
+    commitWarp({duty,gy,q,sag,ts,pwr,mass});
+#endif
+}
+//  bubble i of the panel set (i = 0 is the same as updateWarpUniforms)
+extern "C" EMSCRIPTEN_KEEPALIVE
+void updateBubble(int i,float duty,float gy,float q,float sag,float ts,float pwr,float mass){
+    if(i==0){ updateWarpUniforms(duty,gy,q,sag,ts,pwr,mass); return; }
+    if(i<0 || i>=kMaxBubbles) return;
+    onRenderThread([=]{ commitBubble(i,{duty,gy,q,sag,ts,pwr,mass}); });
+}
+//  number of side‑by‑side panels (1 … kMaxBubbles); re‑lays the grid
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setBubbleCount(int n){
+    onRenderThread([=]{
+        int m = glm::clamp(n,1,kMaxBubbles);
+        for(int i=gBubbleCount;i<m;++i) gBubbles[i] = gWarp;
+        gBubbleCount = m; layoutBubbles(m);
+        ++gWarpGen; bumpShape(); requestRedraw();   // new LUT rows, new panels
+    });
+}
+//  panel i in canvas fractions, origin bottom‑left (GL convention)
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setBubbleRect(int i,float x,float y,float w,float h){
+    onRenderThread([=]{
+        if(i<0 || i>=kMaxBubbles || w<=0.f || h<=0.f) return;
+        gBubbleRect[i] = vec4(x,y,x+w,y+h)*2.f - 1.f;
+        ++gWarpGen; gTemporal.invalidate(); requestRedraw();   // layout: β unchanged
+    });
+}
+//  keyframe for field f (a WarpField) of bubble i at t seconds; ease is
+//  the Ease of the segment that starts here.  Upload keys once, then
+//  timelinePlay(); frame() interpolates with no further bridge calls.
+extern "C" EMSCRIPTEN_KEEPALIVE
+void timelineKey(int i,int f,float t,float value,int ease){
+    onRenderThread([=]{
+        if(i<0 || i>=kMaxBubbles || f<0 || f>=kWarpFloats || t<0.f) return;
+        gTimeline.key(i,f,t,value,glm::clamp(ease,int(kEaseStep),int(kEaseGeometric)));
+    });
+}
+//  drops bubble i's keys (i < 0: all); the fields keep their values
+extern "C" EMSCRIPTEN_KEEPALIVE
+void timelineClear(int i){ onRenderThread([=]{ gTimeline.clear(i); }); }
+//  runs the clock from t seconds at rate× wall time (negative plays
+//  backwards); loop = 1 wraps at the last key instead of stopping
+extern "C" EMSCRIPTEN_KEEPALIVE
+void timelinePlay(float t,float rate,int loop){
+    onRenderThread([=]{ gTimeline.play(t,rate,loop!=0); requestRedraw(); });
 }
+extern "C" EMSCRIPTEN_KEEPALIVE
+void timelineStop(){ onRenderThread([=]{ gTimeline.stop(); }); }
+//  jumps to t seconds (scrubbing); keeps running if it was
+extern "C" EMSCRIPTEN_KEEPALIVE
+void timelineSeek(float t){ onRenderThread([=]{ gTimeline.seek(t); }); }
+//  time of the last evaluation, and whether the clock is still running
+extern "C" EMSCRIPTEN_KEEPALIVE
+float getTimelineTime(){ return float(gTimeline.now); }
+extern "C" EMSCRIPTEN_KEEPALIVE
+int timelineRunning(){ return gTimeline.running; }
+extern "C" EMSCRIPTEN_KEEPALIVE
+void updateCamera(float px,float py,float pz,float tx,float ty,float tz,float fov){
+    onRenderThread([=]{
+        gCam.pos = vec3(px,py,pz); gCam.tgt = vec3(tx,ty,tz); gCam.fov = fov;
+        requestRedraw();
+    });
+}
+//  n inset views over the main one (0 … kMaxViews).  New insets start
+//  stacked down the right edge, alternating an orthographic top and side
+//  view framing bubble 0's support.
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setViewCount(int n){
+    onRenderThread([=]{
+        int m = glm::clamp(n,0,kMaxViews);
+        float R = gWarp.sagDepth_nm*1e-9f;
+        for(int i=gViewCount;i<m;++i){
+            View &v = gViews[i];
+            v.rect = vec4(0.75f,1.f-0.25f*float(i+1),0.25f,0.25f);
+            v.cam.pos   = (i&1 ? vec3(4.f*kSupport,0,0) : vec3(0,4.f*kSupport,0))*R;
+            v.cam.tgt   = vec3(0);
+            v.cam.ortho = 1.2f*kSupport;
+        }
+        gViewCount = m;
+        requestRedraw();
+    });
+}
+//  inset i in canvas fractions, origin bottom‑left (GL convention)
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setViewRect(int i,float x,float y,float w,float h){
+    onRenderThread([=]{
+        if(i<0 || i>=kMaxViews || w<=0.f || h<=0.f) return;
+        gViews[i].rect = vec4(x,y,w,h);
+        requestRedraw();
+    });
+}
+//  inset i's camera as updateCamera(); ortho > 0 makes it orthographic
+//  with that half‑height in units of R (fov is then unused)
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setViewCamera(int i,float px,float py,float pz,float tx,float ty,float tz,float fov,float ortho){
+    onRenderThread([=]{
+        if(i<0 || i>=kMaxViews) return;
+        Camera &c = gViews[i].cam;
+        c.pos = vec3(px,py,pz); c.tgt = vec3(tx,ty,tz); c.fov = fov; c.ortho = std::max(ortho,0.f);
+        requestRedraw();
+    });
+}
+//  1 = sample the baked radial LUT, 0 = evaluate exp() per sample
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setBetaLUT(int on){ onRenderThread([=]{ gUseBetaLUT = on!=0; requestRedraw(); }); }
+//  0 = image, 1 = ray‑step heat map (R channel = steps/255)
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setDebugView(int v){ onRenderThread([=]{ gDebugView = v; requestRedraw(); }); }
+//  share of pixels traced per frame: 1 = all (off), 2 = checkerboard,
+//  4 = one per 2×2 quad; the rest come from the reprojected history
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setTemporal(int fraction){
+    onRenderThread([=]{
+        gTemporal.fraction = fraction>=4 ? 4 : fraction>=2 ? 2 : 1;
+        gTemporal.invalidate(); gQuality.tier = kQualityCustom; requestRedraw();
+    });
+}
+//  ray step budget, clamped to 1 … kMaxSteps (one variant per value used)
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setStepBudget(int n){
+    onRenderThread([=]{
+        gStepBudget = glm::clamp(n,1,kMaxSteps); gQuality.tier = kQualityCustom; requestRedraw();
+    });
+}
+//  0 = redraw every vsync, 1 = redraw only when something changed
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setRenderMode(int mode){ onRenderThread([=]{ gRenderMode = mode; requestRedraw(); }); }
+//  Batch β workspace: JS reserves n points, fills the SoA input view
+//  [x₀…xₙ₋₁ | y… | z…] and reads [βx… | βy… | βz…] after betaBatchRun.
+//  Reserving may grow the heap, so fetch both views after reserving.
+//  A 256³ grid is processed slab by slab (e.g. 256² points per call).
+//  The workspace belongs to the JS caller's thread (the page thread in
+//  the worker build).  These four calls are its only users, so they run
+//  in place, unproxied, and read the field through gBatchShape rather
+//  than from gWarp.
+static std::vector<float> gBatchIn, gBatchOut;
+extern "C" EMSCRIPTEN_KEEPALIVE
+void betaBatchReserve(int n){
+    gBatchIn.resize(3*size_t(n)); gBatchOut.resize(3*size_t(n));
+}
+extern "C" EMSCRIPTEN_KEEPALIVE
+void betaBatchRun(int n){
+    size_t N = gBatchIn.size()/3;
+    if(n<0 || size_t(n)>N) return;
+    const float *in = gBatchIn.data(); float *out = gBatchOut.data();
+    uint64_t shape = gBatchShape.load(std::memory_order_relaxed);
+    float beta0, sag;
+    uint32_t a = uint32_t(shape), b = uint32_t(shape>>32);
+    std::memcpy(&beta0,&a,sizeof(beta0)); std::memcpy(&sag,&b,sizeof(sag));
+    betaFieldBatch(in,in+N,in+2*N,out,out+N,out+2*N,size_t(n),beta0,sag);
+}
+#ifdef __EMSCRIPTEN__
+static emscripten::val betaBatchInput(){
+    return emscripten::val(emscripten::typed_memory_view(gBatchIn.size(),gBatchIn.data()));
+}
+static emscripten::val betaBatchOutput(){
+    return emscripten::val(emscripten::typed_memory_view(gBatchOut.size(),gBatchOut.data()));
+}
+#endif
+//  streams every rendered frame to captureSlots() (see ASYNC CAPTURE);
+//  source is a CaptureSource, kCaptureOff stops
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setCapture(int source){
+    onRenderThread([=]{
+        if(source==kCaptureRGBA8 || source==kCapturePhysics) gCapture.start(source);
+        else gCapture.stop();
+        requestRedraw();
+    });
+}
+//  CPU reference still of bubble 0 from the current camera (threads ≤ 0:
+//  one per core); referenceImage() then views the w·h·4 RGBA8 pixels,
+//  bottom row first.  In place it blocks the caller and returns the wall
+//  time in ms.  The worker build must neither read gWarp/gCam from the
+//  page thread nor block it, so there the call takes the snapshot on the
+//  render thread, traces on a pool thread and returns 0 at once; the
+//  image is swapped in on the page thread when the last tile is done.
+#ifdef WARP_OFFSCREEN
+static void referenceDone(uint32_t gen,float ms,std::vector<uint8_t> &&img);
+static uint32_t gRefGen = 0;                 // page thread: latest referenceStill()
+static void referenceStillAsync(int w,int h,int threads){
+    uint32_t gen = ++gRefGen;
+    onRenderThread([=]{
+        RefScene s = refScene(max(w,1),max(h,1));
+        std::thread([=]{                     // not the render thread: the live view keeps going
+            auto *img = new std::vector<uint8_t>;
+            float ms  = renderReference(s,threads,*img);
+            emscripten_proxy_async(emscripten_proxy_get_system_queue(),emscripten_main_runtime_thread_id(),
+                                   runBoxed,new std::function<void()>([=]{
+                                       referenceDone(gen,ms,std::move(*img)); delete img;
+                                   }));
+        }).detach();
+    });
+}
+extern "C" EMSCRIPTEN_KEEPALIVE
+float referenceStill(int w,int h,int threads){ referenceStillAsync(w,h,threads); return 0.f; }
+#else
+extern "C" EMSCRIPTEN_KEEPALIVE
+float referenceStill(int w,int h,int threads){
+    return renderReference(refScene(max(w,1),max(h,1)),threads,gRefImage);
+}
+#endif
+#ifdef __EMSCRIPTEN__
+static emscripten::val referenceImage(){
+    return emscripten::val(emscripten::typed_memory_view(gRefImage.size(),gRefImage.data()));
+}
+#endif
+#ifdef WARP_OFFSCREEN
+//  worker build: referenceStill with onDone(wall ms) on the page thread
+//  once referenceImage() holds the result; a still superseded by a later
+//  call is dropped, and onDone may be null
+static emscripten::val gRefOnDone = emscripten::val::undefined();
+static void referenceDone(uint32_t gen,float ms,std::vector<uint8_t> &&img){
+    if(gen!=gRefGen) return;
+    gRefImage = std::move(img);
+    if(gRefOnDone.typeOf().as<std::string>()=="function") gRefOnDone(ms);
+}
+static void referenceStillWith(int w,int h,int threads,emscripten::val onDone){
+    gRefOnDone = onDone;
+    referenceStillAsync(w,h,threads);
+}
+#endif
+//  the same still without blocking: frame() traces it in slices of
+//  budgetMs (≤ 0: kStillBudgetMs) until spp samples per pixel, and a
+//  call while one runs starts over.  stillImage() views its w·h·4 RGBA8
+//  pixels, bottom row first, as they refine
+extern "C" EMSCRIPTEN_KEEPALIVE
+void startStill(int w,int h,int spp,float budgetMs){
+    onRenderThread([=]{ gStill.start(w,h,spp,budgetMs); gStill.notify = nullptr; requestRedraw(); });
+}
+//  stops tracing; the image keeps the passes done so far
+extern "C" EMSCRIPTEN_KEEPALIVE
+void cancelStill(){ onRenderThread([]{ gStill.cancel(); }); }
+extern "C" EMSCRIPTEN_KEEPALIVE
+int getStillState(){ return gStill.state; }
+extern "C" EMSCRIPTEN_KEEPALIVE
+float getStillProgress(){ return gStill.progress; }
+//  tracing time of the still so far (not wall time), ms
+extern "C" EMSCRIPTEN_KEEPALIVE
+float getStillMs(){ return gStill.ms; }
+#ifdef __EMSCRIPTEN__
+static emscripten::val stillImage(){
+    return emscripten::val(emscripten::typed_memory_view(gStill.image.size(),gStill.image.data()));
+}
+//  JS callbacks of the latest startStill, owned by the page thread: a
+//  val must not leave the thread that made it.  Slices on the render
+//  thread post (generation, progress, ms) across, and notifications of
+//  a still that has since been restarted are dropped there.
+static emscripten::val gStillOnProgress = emscripten::val::undefined();
+static emscripten::val gStillOnDone     = emscripten::val::undefined();
+static uint32_t        gStillGen        = 0;
+static void callStill(uint32_t gen,bool done,float progress,float ms){
+    if(gen!=gStillGen) return;
+    emscripten::val &f = done ? gStillOnDone : gStillOnProgress;
+    if(f.typeOf().as<std::string>()!="function") return;
+    if(done) f(ms); else f(progress);
+}
+static void stillNotify(bool done){
+    uint32_t gen = gStill.gen; float progress = gStill.progress, ms = gStill.ms;
+#ifdef WARP_OFFSCREEN
+    emscripten_proxy_async(emscripten_proxy_get_system_queue(),emscripten_main_runtime_thread_id(),
+                           runBoxed,new std::function<void()>([=]{ callStill(gen,done,progress,ms); }));
+#else
+    callStill(gen,done,progress,ms);
+#endif
+}
+//  startStill with onProgress(fraction) after every slice and
+//  onDone(tracing ms) once the last pass is in; either may be null
+static void startStillWith(int w,int h,int spp,float budgetMs,
+                           emscripten::val onProgress,emscripten::val onDone){
+    gStillOnProgress = onProgress; gStillOnDone = onDone;
+    uint32_t gen = ++gStillGen;
+    onRenderThread([=]{
+        gStill.start(w,h,spp,budgetMs);
+        gStill.gen = gen; gStill.notify = stillNotify;
+        requestRedraw();
+    });
+}
+#endif
+//  largest devicePixelRatio the canvas is sized for (≤ 0: the device's
+//  own); refits the canvas now
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setMaxPixelRatio(float cap){
+    onRenderThread([=]{ gDprCap = cap; fitCanvas(); requestRedraw(); });
+}
+//  for hosts that size the canvas themselves (e.g. a ResizeObserver in
+//  the page of the worker build): CSS size and DPR, capped as above
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setCanvasSize(float cssW,float cssH,float dpr){
+    onRenderThread([=]{
+        float d = gDprCap > 0.f ? std::min(dpr,gDprCap) : dpr;
+        resizeCanvas(int(cssW*d+0.5f),int(cssH*d+0.5f));
+        requestRedraw();
+    });
+}
+//  target frame time in ms (≤ 0 pins the scale at maxScale) and the
+//  per‑axis bounds the governor may move the internal resolution in
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setResolutionGovernor(float targetMs,float minScale,float maxScale){
+    onRenderThread([=]{
+        gRes.targetMs = targetMs;
+        gRes.minScale = glm::clamp(minScale,0.1f,1.0f);
+        gRes.maxScale = glm::clamp(maxScale,gRes.minScale,1.0f);
+        gRes.scale    = glm::clamp(gRes.scale,gRes.minScale,gRes.maxScale);
+        gQuality.tier = kQualityCustom;
+        requestRedraw();
+    });
+}
+//  one of qualityLow … qualityUltra, or qualityAuto to benchmark on the
+//  next frame and apply the tier it picks
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setQuality(int tier){
+    onRenderThread([=]{
+        if(tier==kQualityAuto) gQuality.bench = true;
+        else if(tier>=kQualityLow && tier<kQualityAuto){ gQuality.bench = false; gQuality.apply(tier); }
+        requestRedraw();
+    });
+}
+//  tier in use (qualityCustom until one is set or after a manual setter)
+extern "C" EMSCRIPTEN_KEEPALIVE
+int getQuality(){ return gQuality.tier; }
+//  median top‑tier frame time of the auto benchmark, 0 before it ran
+extern "C" EMSCRIPTEN_KEEPALIVE
+float getQualityBenchMs(){ return gQuality.benchMs; }
+extern "C" EMSCRIPTEN_KEEPALIVE
+float getRenderScale(){ return gRes.scale; }
+//  1 = march only the screen tiles that can see the β support (default)
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setTileSkip(int on){ onRenderThread([=]{ gTiles.enabled = on!=0; requestRedraw(); }); }
+//  share of tiles the marcher ran on in the last list (1 when disabled)
+extern "C" EMSCRIPTEN_KEEPALIVE
+float getTileCoverage(){ return gTiles.coverage(); }
+//  pointer to gFrameStats (layout in INSTRUMENTATION); refreshed by
+//  every rendered frame, so JS keeps its views and just re‑reads them
+extern "C" EMSCRIPTEN_KEEPALIVE
+const FrameStats* getFrameStats(){ return &gFrameStats; }
+//  n flow tracers (0 = off, at most kTracerMax) advected at timeScale
+//  R/c of coordinate time per second and drawn pointSize px wide
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setTracers(int n,float timeScale,float pointSize){
+    onRenderThread([=]{
+        gTracers.want      = glm::clamp(n,0,kTracerMax);
+        gTracers.timeScale = timeScale;
+        gTracers.pointSize = glm::clamp(pointSize,1.f,64.f);
+        requestRedraw();
+    });
+}
+//  GPU memory budget in MB (see GPU RESOURCES); lowering it below what is
+//  held evicts caches right away.  Usage is in FrameStats::gpu.
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setGpuBudget(float mb){
+    onRenderThread([=]{
+        gGpu.budget = size_t(std::max(mb,0.f)*1048576.0);
+        if(!gGpu.fits(0)) evictCaches(-1,0);
+        requestRedraw();
+    });
+}
+//  1 = render the float physics channels and reduce them every frame
+extern "C" EMSCRIPTEN_KEEPALIVE
+void setPhysics(int on){ onRenderThread([=]{ gPhysics.enable(on!=0); requestRedraw(); }); }
+//  pointer to the PhysicsStats of the newest reduced frame (layout in
+//  PHYSICS CHANNELS); JS keeps its views like for getFrameStats()
+extern "C" EMSCRIPTEN_KEEPALIVE
+const PhysicsStats* getPhysicsStats(){ return &gPhysics.stats; }
+//  compile/link errors so far (empty when everything built); poll it
+//  once FrameStats::shaderState reads kShaderFailed
+std::string getShaderLog(){
+    std::lock_guard<std::mutex> lock(gShaderLogLock);
+    return gShaderLog;
+}
+#ifdef __EMSCRIPTEN__
 EMSCRIPTEN_BINDINGS(my_module){
     emscripten::function("updateWarpUniforms",&updateWarpUniforms);
+    emscripten::function("updateCamera",&updateCamera);
+    emscripten::function("setViewCount",&setViewCount);
+    emscripten::function("setViewRect",&setViewRect);
+    emscripten::function("setViewCamera",&setViewCamera);
+    emscripten::constant("maxViews",kMaxViews);
+    emscripten::function("updateBubble",&updateBubble);
+    emscripten::function("setBubbleCount",&setBubbleCount);
+    emscripten::function("setBubbleRect",&setBubbleRect);
+    emscripten::function("timelineKey",&timelineKey);
+    emscripten::function("timelineClear",&timelineClear);
+    emscripten::function("timelinePlay",&timelinePlay);
+    emscripten::function("timelineStop",&timelineStop);
+    emscripten::function("timelineSeek",&timelineSeek);
+    emscripten::function("getTimelineTime",&getTimelineTime);
+    emscripten::function("timelineRunning",&timelineRunning);
+    emscripten::constant("fieldDuty",int(kFieldDuty));
+    emscripten::constant("fieldGy",int(kFieldGy));
+    emscripten::constant("fieldQ",int(kFieldQ));
+    emscripten::constant("fieldSag",int(kFieldSag));
+    emscripten::constant("fieldTs",int(kFieldTs));
+    emscripten::constant("fieldPower",int(kFieldPower));
+    emscripten::constant("fieldMass",int(kFieldMass));
+    emscripten::constant("easeStep",int(kEaseStep));
+    emscripten::constant("easeLinear",int(kEaseLinear));
+    emscripten::constant("easeSmooth",int(kEaseSmooth));
+    emscripten::constant("easeIn",int(kEaseIn));
+    emscripten::constant("easeOut",int(kEaseOut));
+    emscripten::constant("easeGeometric",int(kEaseGeometric));
+    emscripten::function("setBetaLUT",&setBetaLUT);
+    emscripten::function("setRenderMode",&setRenderMode);
+    emscripten::function("setDebugView",&setDebugView);
+    emscripten::function("setStepBudget",&setStepBudget);
+    emscripten::function("setTemporal",&setTemporal);
+    emscripten::function("requestRedraw",&postRedraw);
+    emscripten::function("warpRingSlots",&warpRingSlots);
+    emscripten::function("warpRingHead",&warpRingHead);
+    emscripten::constant("warpRingSize",kWarpRingSize);
+    emscripten::function("betaBatchReserve",&betaBatchReserve);
+    emscripten::function("betaBatchRun",&betaBatchRun);
+    emscripten::function("betaBatchInput",&betaBatchInput);
+    emscripten::function("betaBatchOutput",&betaBatchOutput);
+    emscripten::function("setCapture",&setCapture);
+    emscripten::function("captureHeader",&captureHeader);
+    emscripten::function("captureSlots",&captureSlots);
+    emscripten::constant("captureOff",int(kCaptureOff));
+    emscripten::constant("captureRGBA8",int(kCaptureRGBA8));
+    emscripten::constant("capturePhysics",int(kCapturePhysics));
+    emscripten::function("setTracers",&setTracers);
+    emscripten::function("setGpuBudget",&setGpuBudget);
+    emscripten::function("setPhysics",&setPhysics);
+    emscripten::constant("physicsOff",uint32_t(kPhysicsOff));
+    emscripten::constant("physicsOn",uint32_t(kPhysicsOn));
+    emscripten::constant("physicsUnsupported",uint32_t(kPhysicsUnsupported));
+    emscripten::constant("physicsNoMemory",uint32_t(kPhysicsNoMemory));
+#ifdef WARP_OFFSCREEN
+    emscripten::function("referenceStill",&referenceStillWith);
+#else
+    emscripten::function("referenceStill",&referenceStill);
+#endif
+    emscripten::function("referenceImage",&referenceImage);
+    emscripten::function("startStill",&startStillWith);
+    emscripten::function("cancelStill",&cancelStill);
+    emscripten::function("getStillState",&getStillState);
+    emscripten::function("getStillProgress",&getStillProgress);
+    emscripten::function("getStillMs",&getStillMs);
+    emscripten::function("stillImage",&stillImage);
+    emscripten::constant("stillIdle",int(kStillIdle));
+    emscripten::constant("stillRunning",int(kStillRunning));
+    emscripten::constant("stillDone",int(kStillDone));
+    emscripten::function("setMaxPixelRatio",&setMaxPixelRatio);
+    emscripten::function("setCanvasSize",&setCanvasSize);
+    emscripten::function("setResolutionGovernor",&setResolutionGovernor);
+    emscripten::function("getRenderScale",&getRenderScale);
+    emscripten::function("setQuality",&setQuality);
+    emscripten::function("getQuality",&getQuality);
+    emscripten::function("getQualityBenchMs",&getQualityBenchMs);
+    emscripten::constant("qualityCustom",int(kQualityCustom));
+    emscripten::constant("qualityLow",int(kQualityLow));
+    emscripten::constant("qualityMedium",int(kQualityMedium));
+    emscripten::constant("qualityHigh",int(kQualityHigh));
+    emscripten::constant("qualityUltra",int(kQualityUltra));
+    emscripten::constant("qualityAuto",int(kQualityAuto));
+    emscripten::function("setTileSkip",&setTileSkip);
+    emscripten::function("getTileCoverage",&getTileCoverage);
+    emscripten::function("getShaderLog",&getShaderLog);
+    emscripten::constant("shaderPending",uint32_t(kShaderPending));
+    emscripten::constant("shaderReady",uint32_t(kShaderReady));
+    emscripten::constant("shaderFailed",uint32_t(kShaderFailed));
 }
+#endif
 
 //---------------------------------------------------------------
 //  MAIN RENDER LOOP
 //---------------------------------------------------------------
-static GLFWwindow *gWin=nullptr;
-static GLuint      gProg=0;
-static int         gW=800,gH=600;
+//  eye ray basis: camera‑to‑world rotation, the two tan(fov/2) scales
+//  of proj() (ortho: the half‑extents) and the eye relative to each
+//  bubble in units of its R
+void syncCamera(const ShaderVariant &sv,const Camera &cam,float aspect){
+    mat3 rot = mat3(inverse(cam.view()));
+    mat4 P   = cam.proj(aspect);
+    vec3 eye[kMaxBubbles];
+    for(int i=0;i<gBubbleCount;++i) eye[i] = cam.eyeR(gBubbles[i].sagDepth_nm);
+    glUniformMatrix3fv(sv.locEyeRot,1,GL_FALSE,value_ptr(rot));
+    glUniform3fv(sv.locEyeR,gBubbleCount,value_ptr(eye[0]));
+    if(cam.ortho > 0.f) glUniform2f(sv.locProjScale,aspect*cam.ortho,cam.ortho);
+    else                glUniform2f(sv.locProjScale,1.0f/P[0][0],1.0f/P[1][1]);
+    glUniform1i(sv.locOrtho,cam.ortho > 0.f);
+}
+void syncCamera(const ShaderVariant &sv){ syncCamera(sv,gCam,float(gW)/float(gH)); }
 
-void frame(){
-    glfwPollEvents();
+//  the LUT is made first, then the targets: making them can evict it
+static ShaderKey currentShaderKey(){
+    ShaderKey k;
+    admitBetaLUT();
+    k.physics  = gDebugView==kDebugOff && gPhysics.active();
+    k.temporal = gDebugView==kDebugOff && !k.physics && gTemporal.ready()
+               ? gTemporal.shaderMode() : 0;                // exact per frame
+    k.maxSteps = gStepBudget; k.debug = gDebugView; k.lut = betaLUTActive();
+    k.lutShift = k.lut ? gLUTShift : 0;
+    return k;
+}
+
+static ShaderVariant gShown;                 // last ready variant drawn
+
+//  binds the requested variant if it is ready, else whatever can stand in
+static void useShaderVariant(const ShaderKey &key){
+    //  a stand‑in whose LUT was evicted cannot be drawn: settle the new one
+    bool stale = gShown.prog && ShaderKey::unpack(gShown.key).lut && !key.lut && !gBetaLUT;
+    ShaderVariant sv = shaderVariant(key,stale);
+    gFrameStats.shaderState = sv.state;
+    if(sv.state==kShaderPending) requestRedraw();      // keep polling
+    if(sv.state==kShaderReady)   gShown = sv;
+    if(gShown.prog){ glUseProgram(gShown.prog); syncCamera(gShown); }
+    else             glUseProgram(gPlaceholder);
+    syncBetaLUT(ShaderKey::unpack(gShown.key).lutShift);   // the stand‑in's row length
+}
+
+//  insets into the canvas with the shown variant, minus the bits that
+//  belong to the main view; the LUT bound for it fits as is, unless a
+//  later allocation this frame evicted it
+static void drawViews(){
+    if(!gViewCount || !gShown.prog) return;
+    ShaderKey k = ShaderKey::unpack(gShown.key);
+    k.temporal = 0; k.physics = false; k.sky = false;
+    if(!gBetaLUT){ k.lut = false; k.lutShift = 0; }
+    ShaderVariant sv = k.pack()==gShown.key ? gShown : shaderVariant(k);
+    if(sv.state!=kShaderReady){ if(sv.state==kShaderPending) requestRedraw(); return; }
+    glBindFramebuffer(GL_FRAMEBUFFER,0);
+    glUseProgram(sv.prog);
+    glBindVertexArray(gVAO);
+    for(int i=0;i<gViewCount;++i){
+        const View &v = gViews[i];
+        int x = int(v.rect.x*float(gW)+0.5f), y = int(v.rect.y*float(gH)+0.5f);
+        int w = max(1,int(v.rect.z*float(gW)+0.5f)), h = max(1,int(v.rect.w*float(gH)+0.5f));
+        glViewport(x,y,w,h);
+        syncCamera(sv,v.cam,float(w)/float(h));
+        glDrawArraysInstanced(GL_TRIANGLES,0,6,gBubbleCount);
+    }
     glViewport(0,0,gW,gH);
-    glClearColor(0,0,0,1); glClear(GL_COLOR_BUFFER_BIT);
+}
+
+//  the marcher key frame() asks for under tier t
+static ShaderKey qualityKey(int t){
+    const QualityPreset &q = kQualityPresets[t];
+    ShaderKey k;
+    k.maxSteps = q.steps; k.lut = betaLUTActive(); k.lutShift = k.lut ? q.lutShift : 0;
+    k.temporal = q.fraction==4 ? 2 : q.fraction==2 ? 1 : 0;
+    return k;
+}
 
+//  kQualityAuto: times the top tier's marcher over the whole canvas, a
+//  1‑pixel readback closing every draw, and applies pick().  Blocks for
+//  about kQualityBenchMaxMs at most; until the variant has linked it
+//  only asks for another frame.
+static void runQualityBench(){
+    admitBetaLUT();
+    ShaderKey k = qualityKey(kQualityUltra);
+    ShaderVariant sv = shaderVariant(k);
+    if(sv.state==kShaderPending){ requestRedraw(); return; }
+    gQuality.bench = false;
+    if(sv.state==kShaderFailed){ gQuality.apply(kQualityLow); return; }
+    glBindFramebuffer(GL_FRAMEBUFFER,gSceneFBO);
+    glViewport(0,0,gW,gH);
     syncUBO();
-    glUseProgram(gProg);
+    glUseProgram(sv.prog); syncCamera(sv);
+    syncBetaLUT(k.lutShift);
     glBindVertexArray(gVAO);
-    glDrawArrays(GL_TRIANGLES,0,6);
+    uint8_t px[4];
+    auto draw = [&]{
+        glDrawArraysInstanced(GL_TRIANGLES,0,6,gBubbleCount);
+        glReadPixels(0,0,1,1,GL_RGBA,GL_UNSIGNED_BYTE,px);   // returns once drawn
+    };
+    draw();                                  // first use pays driver setup
+    std::vector<float> ms;
+    Clock::time_point t0 = Clock::now();
+    do {
+        Clock::time_point t = Clock::now();
+        draw(); ms.push_back(msSince(t));
+    } while(int(ms.size())<kQualityBenchFrames && msSince(t0)<kQualityBenchMaxMs);
+    std::nth_element(ms.begin(),ms.begin()+ms.size()/2,ms.end());
+    gQuality.benchMs = ms[ms.size()/2];
+    gQuality.apply(gQuality.pick());
+    gRes.restart();                          // the bench is not frame time
+}
+
+//  once a tier is in play: submit every tier's variants, run a bench owed
+static void serviceQuality(){
+    if(!gQuality.warmed && (gQuality.bench || gQuality.tier!=kQualityCustom)){
+        for(int t=kQualityLow;t<=kQualityUltra;++t){
+            ShaderKey k = qualityKey(t);
+            shaderVariant(k);
+            k.sky = true; k.temporal = 0;    // the empty‑tile fill of that tier
+            shaderVariant(k);
+        }
+        gQuality.warmed = true;
+    }
+    if(gQuality.bench) runQualityBench();
+}
 
+#ifdef WARP_BENCH
+void benchGrab();                            // BENCHMARK DRIVER
+#endif
+
+void frame(){
+    Clock::time_point t0 = Clock::now(), t;
+    float stillMs = gStill.slice() ? msSince(t0) : 0.f;
+    t0 = Clock::now();                        // the slice is not a frame phase
+#ifndef WARP_OFFSCREEN
+    glfwPollEvents();
+#endif
+    pullWarpRing();
+    gTimeline.tick();                         // keyed fields override the ring
+    gCapture.poll();
+    gPhysics.poll();
+    if(!beginFrame()){ gRes.restart(); return; }   // a tick, not a frame
+    gPhaseHist[kPhasePoll].push(msSince(t0));
+    serviceQuality();
+    gRes.tick(stillMs,gGpuTimer.lastMs);
+    int  rw = max(1,int(gW*gRes.scale+0.5f)), rh = max(1,int(gH*gRes.scale+0.5f));
+    ShaderKey key = currentShaderKey();
+    bool temporal = key.temporal!=0, physics = key.physics;
+    bool direct = !temporal && !physics && rw>=gW && rh>=gH;   // full res: skip the upscale blit
+    glBindFramebuffer(GL_FRAMEBUFFER,temporal ? gTemporal.target() : physics ? gPhysics.fbo :
+                                     direct ? 0 : gSceneFBO);
+    glViewport(0,0,direct ? gW : rw,direct ? gH : rh);
+
+    t = Clock::now();
+    syncUBO();
+    gPhaseHist[kPhaseUBO].push(msSince(t));
+
+    t = Clock::now();
+    useShaderVariant(key);
+    if(temporal) gTemporal.bind(gShown,rw,rh);
+    bool tiled = gShown.prog && gTiles.update(rw,rh);
+    gGpuTimer.begin();
+    if(tiled){
+        gTiles.drawLive();
+        ShaderKey sk = key; sk.sky = true; sk.temporal = 0;
+        ShaderVariant sky = shaderVariant(sk);
+        if(sky.state==kShaderReady){ glUseProgram(sky.prog); syncCamera(sky); }
+        gTiles.drawDead();                   // marcher stands in until it links
+    } else {
+        glBindVertexArray(gVAO);
+        glDrawArraysInstanced(GL_TRIANGLES,0,6,gBubbleCount);
+    }
+    gGpuTimer.end();
+
+    if(temporal){
+        gTemporal.presentTo(gW,gH);
+        if(gTemporal.converging()) requestRedraw();    // on‑demand: keep refining
+    } else if(!direct){
+        glBindFramebuffer(GL_READ_FRAMEBUFFER,physics ? gPhysics.fbo : gSceneFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER,0);
+        glBlitFramebuffer(0,0,rw,rh,0,0,gW,gH,GL_COLOR_BUFFER_BIT,GL_LINEAR);
+    }
+    gTracers.frame();
+    if(gTracers.count) requestRedraw();        // on‑demand: the flow keeps moving
+    drawViews();
+    if(physics) gPhysics.reduce(rw,rh);
+    gCapture.record(rw,rh,physics);
+    gPhaseHist[kPhaseDraw].push(msSince(t));
+
+#ifdef WARP_BENCH
+    benchGrab();                             // the back buffer is undefined after the swap
+#endif
+    t = Clock::now();
+#ifndef WARP_OFFSCREEN
     glfwSwapBuffers(gWin);
+#endif
+    gPhaseHist[kPhaseSwap].push(msSince(t));
+    gGpuTimer.poll();
+    gPhaseHist[kPhaseFrame].push(msSince(t0));
+    publishFrameStats();
+    storeShaderCache();
 }
 
+//---------------------------------------------------------------
+//  BENCHMARK DRIVER  (-DWARP_BENCH)
+//---------------------------------------------------------------
+//  Replaces the interactive loop: for every preset the fixed default
+//  gCam renders kBenchWarmup + kBenchFrames frames at full resolution,
+//  each closed by a 1‑px glReadPixels so the CPU wall time covers the
+//  GPU work too.  One extra frame in the step‑count debug view is read
+//  back whole to get exact per‑pixel ray steps.  The per‑primitive
+//  micro‑benchmarks follow the presets.  Everything is printed as a
+//  single JSON document on stdout, and then the runtime exits.
+#ifdef WARP_BENCH
+#ifndef WARP_BENCH_FRAMES
+#define WARP_BENCH_FRAMES 120
+#endif
+constexpr int kBenchWarmup = 10;
+constexpr int kBenchFrames = WARP_BENCH_FRAMES;
+#ifdef __wasm_simd128__
+constexpr bool kBenchSimd = true;           // betaFieldBatch's 4‑wide path
+#else
+constexpr bool kBenchSimd = false;
+#endif
+
+struct BenchPreset { const char *name; WarpUniforms w; };
+static std::vector<BenchPreset> benchPresets(){
+    const WarpUniforms hover = {0.14f,26.0f,1e9f,16.0f,4102.74f,83.3f,1405.0f};
+    std::vector<BenchPreset> v = {{"hover",hover}};
+    static char names[32][48];
+    int n = 0;
+    for(float duty : {0.05f,0.14f,0.35f,1.0f})
+        for(float gy : {13.0f,26.0f,52.0f}){
+            WarpUniforms w = hover; w.dutyCycle = duty; w.g_y = gy;
+            std::snprintf(names[n],sizeof(names[n]),"duty%.2f_gy%.0f",duty,gy);
+            v.push_back({names[n++],w});
+        }
+    for(float sag : {8.0f,32.0f}){
+        WarpUniforms w = hover; w.sagDepth_nm = sag;
+        std::snprintf(names[n],sizeof(names[n]),"hover_sag%.0f",sag);
+        v.push_back({names[n++],w});
+    }
+    return v;
+}
+
+static void printMs(const char *key,const PhaseStats &s,bool valid){
+    if(!valid){ std::printf("\"%s\":null",key); return; }
+    std::printf("\"%s\":{\"mean\":%.4f,\"p50\":%.4f,\"p95\":%.4f,\"max\":%.4f}",
+                key,s.mean,s.p50,s.p95,s.max);
+}
+
+//  Micro‑benchmarks of the hot primitives, run once after the last
+//  preset and printed as "micro":[…].  A sample is one call of
+//  op(reps).  reps doubles until such a call takes kMicroSampleMs, so
+//  timer granularity (coarse performance.now() without cross‑origin
+//  isolation) stays out of the spread.  After one warm‑up call,
+//  kMicroSamples timed calls give the per‑op median, p95 and MAD
+//  (median absolute deviation), plus reps and the sample count.  The
+//  binary only prints them; comparing two runs' documents is left to
+//  the caller, which can weigh a median shift against the MAD.  The
+//  samples are:
+//      betaField        scalar per‑point field over kMicroPoints points
+//      betaFieldBatch   the same points with the SoA sampler (SIMD when
+//                       built with -msimd128, see "simd")
+//      bridge.embind    Module.updateWarpUniforms called from JS
+//                       (natively bridge.direct: the C entry point)
+//      bridge.ring      JS writes into warpRingSlots/warpRingHead
+//                       (natively pushWarpRing), plus the engine's one
+//                       pullWarpRing per burst
+//      syncUBO          one BubbleGPU block upload (CPU side)
+//      compile.<v>      compile + link of one marcher variant, ms;
+//                       every sample is salted past the driver caches
+#ifndef WARP_BENCH_MICRO_SAMPLES
+#define WARP_BENCH_MICRO_SAMPLES 31
+#endif
+constexpr int    kMicroSamples  = WARP_BENCH_MICRO_SAMPLES;
+constexpr int    kMicroCompiles = 7;        // samples per shader variant
+constexpr int    kMicroPoints   = 1024;     // β sample points (L1 sized)
+constexpr double kMicroSampleMs = 10.0;
+
+struct MicroStats { double median, p95, mad; int reps, samples; };
+
+static MicroStats microStats(std::vector<double> v,int reps){
+    int n = int(v.size()), i50 = n/2, i95 = min(n-1,(n*95)/100);
+    std::sort(v.begin(),v.end());
+    MicroStats m{v[size_t(i50)],v[size_t(i95)],0.0,reps,n};
+    for(double &x : v) x = std::fabs(x-m.median);
+    std::nth_element(v.begin(),v.begin()+i50,v.end());
+    m.mad = v[size_t(i50)];
+    return m;
+}
+static double nsSince(Clock::time_point t0){
+    return std::chrono::duration<double,std::nano>(Clock::now()-t0).count();
+}
+//  ns per op of op(reps)
+template<class F> static MicroStats microTime(F &&op){
+    int reps = 1;
+    for(;;){
+        Clock::time_point t = Clock::now();
+        op(reps);
+        if(nsSince(t) >= kMicroSampleMs*1e6 || reps >= (1<<24)) break;
+        reps *= 2;
+    }
+    op(reps);
+    std::vector<double> ns;
+    for(int i=0;i<kMicroSamples;++i){
+        Clock::time_point t = Clock::now();
+        op(reps);
+        ns.push_back(nsSince(t)/double(reps));
+    }
+    return microStats(std::move(ns),reps);
+}
+
+static void printMicro(bool &first,const char *name,const char *unit,const MicroStats &m){
+    std::printf("%s{\"name\":\"%s\",\"unit\":\"%s\",\"reps\":%d,\"samples\":%d,"
+                "\"median\":%.4f,\"p95\":%.4f,\"mad\":%.4f}",
+                first ? "" : ",",name,unit,m.reps,m.samples,m.median,m.p95,m.mad);
+    first = false;
+}
+
+static void runMicroBench(){
+    bool first = true;
+    std::printf(",\"micro\":[");
+
+    // β over a ±2R cube, Halton‑spread so no two runs differ
+    const float R = gWarp.sagDepth_nm*1e-9f;
+    std::vector<float> in(3*size_t(kMicroPoints)), out(3*size_t(kMicroPoints));
+    for(int i=0;i<kMicroPoints;++i)
+        for(int c=0;c<3;++c)
+            in[size_t(c*kMicroPoints+i)] = (halton(uint32_t(i+1),c==0 ? 2 : c==1 ? 3 : 5)*4.f-2.f)*R;
+    volatile float sink = 0.f;
+    MicroStats m = microTime([&](int reps){
+        float acc = 0.f;
+        for(int r=0;r<reps;++r){
+            const int i = r%kMicroPoints;
+            vec3 b = betaField(vec3(in[size_t(i)],in[size_t(kMicroPoints+i)],in[size_t(2*kMicroPoints+i)]));
+            acc += b.x;
+        }
+        sink = acc;
+    });
+    printMicro(first,"betaField","ns/point",m);
+    m = microTime([&](int reps){
+        const float *x = in.data();
+        float *o = out.data();
+        for(int r=0;r<reps;++r)
+            betaFieldBatch(x,x+kMicroPoints,x+2*kMicroPoints,o,o+kMicroPoints,o+2*kMicroPoints,
+                           size_t(kMicroPoints));
+        sink = out[0];
+    });
+    m.median /= kMicroPoints; m.p95 /= kMicroPoints; m.mad /= kMicroPoints;
+    printMicro(first,"betaFieldBatch","ns/point",m);
+    (void)sink;
+
+    // bridge: every update differs (pwr), so none is dropped as a no‑op
+    const WarpUniforms w0 = gWarp;
+#ifdef __EMSCRIPTEN__
+    m = microTime([&](int reps){
+        EM_ASM({
+            var f = Module['updateWarpUniforms'];
+            for(var i=0;i<$0;++i) f($1,$2,$3,$4,$5,$6 + (i&1),$7);
+        },reps,w0.dutyCycle,w0.g_y,w0.cavityQ,w0.sagDepth_nm,w0.tsRatio,w0.powerAvg_MW,w0.exoticMass_kg);
+    });
+    printMicro(first,"bridge.embind","ns/update",m);
+    m = microTime([&](int reps){
+        EM_ASM({
+            var s = Module['warpRingSlots'](), h = Module['warpRingHead']();
+            for(var i=0;i<$0;++i){
+                var o = (h[0] % $8)*7;
+                s[o] = $1; s[o+1] = $2; s[o+2] = $3; s[o+3] = $4;
+                s[o+4] = $5; s[o+5] = $6 + (i&1); s[o+6] = $7;
+                Atomics.add(h,0,1);
+            }
+        },reps,w0.dutyCycle,w0.g_y,w0.cavityQ,w0.sagDepth_nm,w0.tsRatio,w0.powerAvg_MW,w0.exoticMass_kg,
+          kWarpRingSize);
+        pullWarpRing();
+    });
+#else
+    m = microTime([&](int reps){
+        for(int i=0;i<reps;++i)
+            updateWarpUniforms(w0.dutyCycle,w0.g_y,w0.cavityQ,w0.sagDepth_nm,w0.tsRatio,
+                               w0.powerAvg_MW+float(i&1),w0.exoticMass_kg);
+    });
+    printMicro(first,"bridge.direct","ns/update",m);
+    m = microTime([&](int reps){
+        WarpUniforms w = w0;
+        for(int i=0;i<reps;++i){ w.powerAvg_MW = w0.powerAvg_MW+float(i&1); pushWarpRing(w); }
+        pullWarpRing();
+    });
+#endif
+    printMicro(first,"bridge.ring","ns/update",m);
+    commitWarp(w0);
+
+    m = microTime([&](int reps){
+        for(int i=0;i<reps;++i){ ++gWarpGen; syncUBO(); }
+    });
+    printMicro(first,"syncUBO","ns/upload",m);
+
+    // one marcher variant per feature the tiers and views switch on
+    struct CompileCase { const char *name; ShaderKey key; };
+    std::vector<CompileCase> cases;
+    static const char *tierNames[] = {"compile.low","compile.medium","compile.high","compile.ultra"};
+    for(int t=kQualityLow;t<=kQualityUltra;++t) cases.push_back({tierNames[t],qualityKey(t)});
+    ShaderKey k = qualityKey(kQualityUltra); k.temporal = 0;
+    k.sky = true;                      cases.push_back({"compile.sky",k});
+    k.sky = false; k.debug = kDebugSteps; cases.push_back({"compile.steps",k});
+    k.debug = kDebugOff; k.physics = true; cases.push_back({"compile.physics",k});
+    static uint32_t salt = 0;
+    for(const CompileCase &c : cases){
+        std::vector<double> ms;
+        for(int i=0;i<=kMicroCompiles;++i){           // sample 0 warms up
+            char line[48];
+            std::snprintf(line,sizeof(line),"#define WARP_BENCH_SALT %u\n",++salt);
+            ShaderVariant v;
+            Clock::time_point t = Clock::now();
+            startVariant(v,c.key,line);
+            GLint ok = 0;
+            glGetProgramiv(v.prog,GL_LINK_STATUS,&ok);        // blocks until linked
+            if(i>0) ms.push_back(nsSince(t)*1e-6);
+            glDeleteShader(v.vs); glDeleteShader(v.fs); glDeleteProgram(v.prog);
+        }
+        printMicro(first,c.name,"ms",microStats(std::move(ms),1));
+    }
+    std::printf("]");
+}
+
+struct Bench {
+    std::vector<BenchPreset> presets = benchPresets();
+    size_t cur   = 0;
+    int    frame = -kBenchWarmup;
+    bool   first = true;
+    RollingHist wall;                        // bench frames only, incl. GPU
+    bool   grab  = false;                    // next frame: read the canvas back into px
+    std::vector<uint8_t> px;
+} gBench;
+
+//  frame()'s hook just before the swap
+void benchGrab(){
+    Bench &b = gBench;
+    if(!b.grab) return;
+    b.grab = false;
+    b.px.resize(size_t(gW)*gH*4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,0);
+    glReadPixels(0,0,gW,gH,GL_RGBA,GL_UNSIGNED_BYTE,b.px.data());
+}
+
+void benchFrame(){
+    Bench &b = gBench;
+    if(b.cur==b.presets.size()){
+        std::printf("]");
+        runMicroBench();
+        std::printf("}\n"); std::fflush(stdout);
+        loopExit(0);
+        return;
+    }
+    const BenchPreset &pr = b.presets[b.cur];
+    if(b.frame==-kBenchWarmup){
+        if(b.first) std::printf("{\"bench\":\"warp_engine\",\"width\":%d,\"height\":%d,"
+                                "\"frames\":%d,\"maxSteps\":%d,\"simd\":%s,\"presets\":[",
+                                gW,gH,kBenchFrames,gStepBudget,kBenchSimd ? "true" : "false");
+        commitWarp(pr.w);
+        gRes.targetMs = 0.f; gRenderMode = kRenderContinuous; gDebugView = 0;
+        shaderVariant(currentShaderKey(),true);    // never time the placeholder
+    }
+    if(b.frame==0){ for(RollingHist &h : gPhaseHist) h = RollingHist{}; b.wall = RollingHist{}; }
+
+    Clock::time_point t0 = Clock::now();
+    frame();
+    uint8_t probe[4]; glReadPixels(0,0,1,1,GL_RGBA,GL_UNSIGNED_BYTE,probe);
+    float ms = msSince(t0);
+    if(b.frame>=0) b.wall.push(ms);          // frame() keeps its CPU time in kPhaseFrame
+
+    if(++b.frame < kBenchFrames) return;
+
+    PhaseStats wall{};
+    b.wall.summarize(wall);
+    gPhaseHist[kPhaseGPU].summarize(gFrameStats.phase[kPhaseGPU]);
+    PhaseStats gpu = gFrameStats.phase[kPhaseGPU];
+    bool gpuValid = gGpuTimer.live && gPhaseHist[kPhaseGPU].count>0;
+
+    // exact ray‑step statistics from the debug view
+    gDebugView = kDebugSteps; shaderVariant(currentShaderKey(),true);
+    b.grab = true; requestRedraw(); frame();
+    double sum = 0; int mx = 0;
+    for(size_t i=0;i<b.px.size();i+=4){ sum += b.px[i]; mx = max(mx,int(b.px[i])); }
+    gDebugView = 0;
+
+    const WarpUniforms &w = pr.w;
+    std::printf("%s{\"name\":\"%s\",\"dutyCycle\":%g,\"g_y\":%g,\"sagDepth_nm\":%g,",
+                b.first ? "" : ",",pr.name,w.dutyCycle,w.g_y,w.sagDepth_nm);
+    printMs("frameMs",wall,true); std::printf(",");
+    printMs("gpuDrawMs",gpu,gpuValid);
+    std::printf(",\"steps\":{\"mean\":%.3f,\"max\":%d,\"total\":%.0f}}",
+                sum/double(size_t(gW)*gH),mx,sum);
+    std::fflush(stdout);
+    b.first = false; ++b.cur; b.frame = -kBenchWarmup;
+}
+#endif
+
 int main(){
-    gWin = initGL(gW,gH);
-    gProg= createProgram();
+#ifdef WARP_OFFSCREEN
+    gRenderThread = pthread_self();          // PROXY_TO_PTHREAD: not the page thread
+#endif
+    if(!initGL(gW,gH)) return 1;
+    fitCanvas();                             // drawing buffer + gSceneFBO first
+    initShaderVariants();
+    loadShaderCache();                       // natively this restores the binaries now …
+    shaderVariant(currentShaderKey());       // … so only a miss compiles the default from source
     initQuad();
+    gGpuTimer.init();
 
-    // --- allocate UBO & bind to both GL & GLSL layout(index=0) ---
-    glGenBuffers(1,&gUBO);
-    glBindBuffer(GL_UNIFORM_BUFFER,gUBO);
-    glBufferData(GL_UNIFORM_BUFFER,sizeof(WarpUniforms),nullptr,GL_DYNAMIC_DRAW);
-    GLuint block = glGetUniformBlockIndex(gProg,"WarpUniforms");
-    glUniformBlockBinding(gProg,block,0);    // both sides point @ 0
-    glBindBufferBase(GL_UNIFORM_BUFFER,0,gUBO);
+    // --- allocate UBO ring; every variant's block is bound @ 0 ---
+    initUBO();
+    syncUBO();                               // first upload binds slot range
+
+    canvasOnResize(onResize);
 
     // animation callback (browser drives at vsync)
-    emscripten_set_main_loop(frame,0,1);
+#ifdef WARP_BENCH
+    loopRun(benchFrame);
+#else
+    loopRun(frame);
+#endif
     return 0;
 }